@@ -2,47 +2,231 @@
 // Created by Kehinde Adeoso on 8/9/25.
 //
 #include "CHIP8.h"
+#include "CHIP8BootImage.h"
+#include "Telemetry.h"
 
+#include <atomic>
+#include <chrono>
 
-void CHIP8Context::CPUReset() {
+
+void CHIP8Context::CPUReset(const CHIP8BootImage& image) {
+    // A fresh seed per reset keeps CXNN unpredictable. The clock plus a reset counter is plenty for a
+    // game's dice and, unlike std::random_device, costs nanoseconds rather than a system call.
+    static std::atomic<uint32_t> resets{0};
+    uint64_t seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())
+                  ^ (static_cast<uint64_t>(resets.fetch_add(1, std::memory_order_relaxed)) * 0x9E3779B97F4A7C15ull);
+    // splitmix64 finalizer, so consecutive resets get unrelated seeds
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+    seed ^= seed >> 31;
+    image.boot(*this, static_cast<uint32_t>(seed ^ (seed >> 32)));
+}
+
+void CHIP8Context::resetState() {
     m_AddressI = 0 ;
     m_ProgramCounter = 0x200;
+    m_StackPointer = 0;
 
     m_DelayTimer = 0;
     m_SoundTimer = 0;
 
     // set all registers to 0
     memset(m_Registers,0,sizeof(m_Registers));
-    memset(m_Keypad, 0, sizeof(m_Keypad));
+    memset(m_Stack, 0, sizeof(m_Stack));
+    m_Keypad = 0;
     memset(m_ScreenData, 0, sizeof(m_ScreenData));
+    m_BlockMapId = 0;
+
+    // Zeroed RAM with the font in place, ready for a ROM
+    std::memcpy(m_GameMemory, CHIP8BootImage::POWER_ON_MEMORY.m_Bytes, sizeof(m_GameMemory));
+}
+
+size_t CHIP8Context::loadROM(const BYTE* rom, size_t size) {
+    const size_t loadOffset = 0x200;                            // Programs start at 0x200
+    const size_t capacity   = sizeof(m_GameMemory) - loadOffset; // bytes available for ROM
+
+    const size_t bytesLoaded = size < capacity ? size : capacity;
+    std::memcpy(&m_GameMemory[loadOffset], rom, bytesLoaded);
+    return bytesLoaded;
+}
+
+void CHIP8Context::seedRandom(uint32_t seed) {
+    m_RandomState = seed ? seed : 0x2545F491u;
+}
+
+void CHIP8Context::runCycles(int count) {
+    CHIP8_PROFILE_SCOPE("runCycles");
+    m_BlockMapId = 0; // writes over code go unnoticed here
+    for (int i = 0; i < count; i++) {
+        execute();
+        tickTimers();
+    }
+}
 
-    // Load ROM safely (relative path recommended)
-    const size_t loadOffset = 0x200;                    // Programs start at 0x200
-    const size_t memSize    = 0x1000;                   // 4 KB total
-    const size_t capacity   = memSize - loadOffset;     // bytes available for ROM
+void CHIP8Context::runCycles(int count, const CHIP8KeyEvent* events, size_t eventCount) {
+    CHIP8_PROFILE_SCOPE("runCycles");
+    m_BlockMapId = 0; // writes over code go unnoticed here
+    size_t next = 0;
+    for (int i = 0; i < count; i++) {
+        while (next < eventCount && events[next].cycle <= i) {
+            applyKeyEvent(events[next++]);
+        }
+        execute();
+        tickTimers();
+    }
 
-    // Zero out RAM before loading
-    std::memset(m_GameMemory, 0, memSize);
+    // Anything stamped past the end of the batch still has to land before the next one.
+    while (next < eventCount) {
+        applyKeyEvent(events[next++]);
+    }
+}
 
-    FILE* in = std::fopen("insert/your/absolute/filepath/here", "rb"); // use relative path;
-    if (!in) {
-        perror("Failed to open ROM");
+void CHIP8Context::runCyclesPredecoded(const CHIP8BlockMap& map, int count, const CHIP8KeyEvent* events,
+                                       size_t eventCount) {
+    if (m_BlockMapId != map.m_Id) {
+        runCycles(count, events, eventCount);
         return;
     }
 
-    // Read up to capacity bytes starting at 0x200
-    const size_t bytesRead = std::fread(&m_GameMemory[loadOffset], 1, capacity, in);
-    (void)bytesRead; // optionally log bytesRead
-    std::fclose(in);
+    CHIP8_PROFILE_SCOPE("runCycles");
+    size_t next = 0;
+    for (int i = 0; i < count; i++) {
+        while (next < eventCount && events[next].cycle <= i) {
+            applyKeyEvent(events[next++]);
+        }
+        if (m_BlockMapId) {
+            executePredecoded(map);
+        } else {
+            execute();
+        }
+        tickTimers();
+    }
+
+    while (next < eventCount) {
+        applyKeyEvent(events[next++]);
+    }
+}
+
+void CHIP8Context::executePredecoded(const CHIP8BlockMap& map) {
+    const WORD pc = m_ProgramCounter & 0x0FFF;
+    const CHIP8BlockMap::Entry& entry = map.m_Entries[pc];
+    WORD opcode;
+    CHIP8Op op;
+    if (entry.m_Decoded) {
+        opcode = entry.m_Opcode;
+        op = entry.m_Op;
+    } else {
+        opcode = static_cast<WORD>((m_GameMemory[pc] << 8) | m_GameMemory[(pc + 1) & 0x0FFF]);
+        op = decodeOpcode(opcode);
+    }
+
+    // The only instructions that write memory. Once one lands on decoded code, memory is the truth.
+    int written = 0;
+    if (op == CHIP8Op::OP_FX33) {
+        written = 3;
+    } else if (op == CHIP8Op::OP_FX55) {
+        written = ((opcode & 0x0F00) >> 8) + 1;
+    }
+    for (int i = 0; i < written; ++i) {
+        if (map.coversByte(static_cast<WORD>(m_AddressI + i))) {
+            m_BlockMapId = 0;
+            break;
+        }
+    }
+
+    m_ProgramCounter = pc + 2;
+    dispatch(op, opcode);
+}
+
+void CHIP8Context::applyKeyEvent(const CHIP8KeyEvent& event) {
+    const uint16_t bit = static_cast<uint16_t>(1u << (event.key & 0x0F));
+    if (event.pressed) {
+        m_Keypad |= bit;
+    } else {
+        m_Keypad &= static_cast<uint16_t>(~bit);
+    }
+}
+
+void CHIP8Context::tickTimers() {
+    if (m_DelayTimer > 0) {
+        m_DelayTimer--;
+    }
+
+    if (m_SoundTimer > 0) {
+        m_SoundTimer--;
+    }
+}
+
+namespace {
+    // Four independent 8-byte lanes so the multiplies overlap, then a final avalanche. State hashing
+    // runs once per explored state, so it needs to cost about as much as emulating a frame.
+    uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        const uint64_t prime = 0x100000001B3ull;
+
+        if (size >= 32) {
+            uint64_t a = hash, b = hash ^ 0x9E3779B97F4A7C15ull, c = hash ^ 0xC2B2AE3D27D4EB4Full, d = hash ^ 0x165667B19E3779F9ull;
+            while (size >= 32) {
+                uint64_t words[4];
+                std::memcpy(words, bytes, 32);
+                a = (a ^ words[0]) * prime; a ^= a >> 29;
+                b = (b ^ words[1]) * prime; b ^= b >> 29;
+                c = (c ^ words[2]) * prime; c ^= c >> 29;
+                d = (d ^ words[3]) * prime; d ^= d >> 29;
+                bytes += 32;
+                size -= 32;
+            }
+            const uint64_t lanes[3] = { b, c, d };
+            hash = a;
+            for (uint64_t lane : lanes) {
+                hash = (hash ^ lane) * prime;
+                hash ^= hash >> 29;
+            }
+        }
+
+        while (size >= 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes, 8);
+            hash = (hash ^ word) * prime;
+            hash ^= hash >> 29;
+            bytes += 8;
+            size -= 8;
+        }
+        while (size > 0) {
+            hash = (hash ^ *bytes++) * prime;
+            --size;
+        }
+        return hash;
+    }
+}
+
+uint64_t CHIP8Context::stateHash() const {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hash = hashBytes(hash, m_GameMemory, sizeof(m_GameMemory));
+    hash = hashBytes(hash, m_ScreenData, sizeof(m_ScreenData));
+    hash = hashBytes(hash, m_Registers, sizeof(m_Registers));
+    hash = hashBytes(hash, m_Stack, m_StackPointer * sizeof(WORD));
+
+    const uint64_t scalars[] = {
+        m_AddressI, m_ProgramCounter, m_StackPointer, m_Keypad, m_DelayTimer, m_SoundTimer, m_RandomState
+    };
+    hash = hashBytes(hash, scalars, sizeof(scalars));
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
 }
 
 CHIP8Context::WORD CHIP8Context::GetNextOpcode()
 {
+    // BNNN and skips can leave PC past the end of memory; fetches wrap around the 4K address space.
+    const WORD pc = m_ProgramCounter & 0x0FFF;
     WORD res = 0 ;
-    res = m_GameMemory[m_ProgramCounter] ; // in example res is 0xAB
+    res = m_GameMemory[pc] ; // in example res is 0xAB
     res <<= 8 ; // shift 8 bits left. In our example res is 0xAB00
-    res |= m_GameMemory[m_ProgramCounter+1] ; // In example res is 0xABCD
-    m_ProgramCounter+=2 ;
+    res |= m_GameMemory[(pc + 1) & 0x0FFF] ; // In example res is 0xABCD
+    m_ProgramCounter = pc + 2 ;
     return res ;
 }
 
@@ -199,69 +383,58 @@ void CHIP8Context::execute() {
 }
 
 
-// Helper functions
-
-bool CHIP8Context::isKeyPressed(const BYTE &key) const {
-    if (key > 0x0F) {
-        return false; // invalid key
+void CHIP8Context::dispatch(CHIP8Op op, WORD opcode) {
+    switch (op) {
+        case CHIP8Op::OP_00E0: OPCode00E0(); break;
+        case CHIP8Op::OP_00EE: OPCode00EE(); break;
+        case CHIP8Op::OP_1NNN: OPCode1NNN(opcode); break;
+        case CHIP8Op::OP_2NNN: OPCode2NNN(opcode); break;
+        case CHIP8Op::OP_3XNN: OPCode3XNN(opcode); break;
+        case CHIP8Op::OP_4XNN: OPCode4XNN(opcode); break;
+        case CHIP8Op::OP_5XY0: OPCode5XY0(opcode); break;
+        case CHIP8Op::OP_6XNN: OPCode6XNN(opcode); break;
+        case CHIP8Op::OP_7XNN: OPCode7XNN(opcode); break;
+        case CHIP8Op::OP_8XY0: OPCode8XY0(opcode); break;
+        case CHIP8Op::OP_8XY1: OPCode8XY1(opcode); break;
+        case CHIP8Op::OP_8XY2: OPCode8XY2(opcode); break;
+        case CHIP8Op::OP_8XY3: OPCode8XY3(opcode); break;
+        case CHIP8Op::OP_8XY4: OPCode8XY4(opcode); break;
+        case CHIP8Op::OP_8XY5: OPCode8XY5(opcode); break;
+        case CHIP8Op::OP_8XY6: OPCode8XY6(opcode); break;
+        case CHIP8Op::OP_8XY7: OPCode8XY7(opcode); break;
+        case CHIP8Op::OP_8XYE: OPCode8XYE(opcode); break;
+        case CHIP8Op::OP_9XY0: OPCode9XY0(opcode); break;
+        case CHIP8Op::OP_ANNN: OPCodeANNN(opcode); break;
+        case CHIP8Op::OP_BNNN: OPCodeBNNN(opcode); break;
+        case CHIP8Op::OP_CXNN: OPCodeCXNN(opcode); break;
+        case CHIP8Op::OP_DXYN: OPCodeDXYN(opcode); break;
+        case CHIP8Op::OP_EX9E: OPCodeEX9E(opcode); break;
+        case CHIP8Op::OP_EXA1: OPCodeEXA1(opcode); break;
+        case CHIP8Op::OP_FX07: OPCodeFX07(opcode); break;
+        case CHIP8Op::OP_FX0A: OPCodeFX0A(opcode); break;
+        case CHIP8Op::OP_FX15: OPCodeFX15(opcode); break;
+        case CHIP8Op::OP_FX18: OPCodeFX18(opcode); break;
+        case CHIP8Op::OP_FX1E: OPCodeFX1E(opcode); break;
+        case CHIP8Op::OP_FX29: OPCodeFX29(opcode); break;
+        case CHIP8Op::OP_FX33: OPCodeFX33(opcode); break;
+        case CHIP8Op::OP_FX55: OPCodeFX55(opcode); break;
+        case CHIP8Op::OP_FX65: OPCodeFX65(opcode); break;
+        default: // Undefined opcodes are ignored.
+            break;
     }
-
-    return m_Keypad[key] != 0;
 }
 
-void CHIP8Context::render(SDL_Renderer* renderer) {
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black
-    SDL_RenderClear(renderer);
-
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White
-    int scale = 10; // 64*10=640, 32*10=320
-    for (int y = 0; y < 32; ++y) {
-        for (int x = 0; x < 64; ++x) {
-            if (m_ScreenData[x][y]) {
-                SDL_Rect rect = { x * scale, y * scale, scale, scale };
-                SDL_RenderFillRect(renderer, &rect);
-            }
-        }
-    }
 
-    SDL_RenderPresent(renderer);
-}
-
-void CHIP8Context::processInput(CHIP8Context& chip8, SDL_Event& e, bool& running) {
-    // Update internal keyboard state snapshot
-    SDL_PumpEvents();
+// Helper functions
 
-    // Handle window close without draining keyboard events
-    if (SDL_QuitRequested()) {
-        running = false;
-        return;
+bool CHIP8Context::isKeyPressed(const BYTE &key) const {
+    if (key > 0x0F) {
+        return false; // invalid key
     }
 
-    // Map current keyboard state to CHIP-8 keypad (0..F)
-    const Uint8* s = SDL_GetKeyboardState(nullptr);
-
-    chip8.m_Keypad[0x1] = s[SDL_SCANCODE_1];
-    chip8.m_Keypad[0x2] = s[SDL_SCANCODE_2];
-    chip8.m_Keypad[0x3] = s[SDL_SCANCODE_3];
-    chip8.m_Keypad[0xC] = s[SDL_SCANCODE_4];
-
-    chip8.m_Keypad[0x4] = s[SDL_SCANCODE_Q];
-    chip8.m_Keypad[0x5] = s[SDL_SCANCODE_W];
-    chip8.m_Keypad[0x6] = s[SDL_SCANCODE_E];
-    chip8.m_Keypad[0xD] = s[SDL_SCANCODE_R];
-
-    chip8.m_Keypad[0x7] = s[SDL_SCANCODE_A];
-    chip8.m_Keypad[0x8] = s[SDL_SCANCODE_S];
-    chip8.m_Keypad[0x9] = s[SDL_SCANCODE_D];
-    chip8.m_Keypad[0xE] = s[SDL_SCANCODE_F];
-
-    chip8.m_Keypad[0xA] = s[SDL_SCANCODE_Z];
-    chip8.m_Keypad[0x0] = s[SDL_SCANCODE_X];
-    chip8.m_Keypad[0xB] = s[SDL_SCANCODE_C];
-    chip8.m_Keypad[0xF] = s[SDL_SCANCODE_V];
+    return (m_Keypad >> key) & 1;
 }
 
-
 // OPCodes
 
 /**
@@ -279,9 +452,8 @@ void CHIP8Context::OPCode1NNN(const WORD& opcode) {
 * @post Returns to a subroutine.
 */
 void CHIP8Context::OPCode00EE() {
-    if (!m_Stack.empty()) {
-        m_ProgramCounter = m_Stack.top();
-        m_Stack.pop();
+    if (m_StackPointer > 0) {
+        m_ProgramCounter = m_Stack[--m_StackPointer];
     } else {
         // Handle stack underflow error
         m_ProgramCounter = 0x200; // reset to start or handle error appropriately.
@@ -294,8 +466,10 @@ void CHIP8Context::OPCode00EE() {
 * @post Calls subroutine at NNN.
 */
 void CHIP8Context::OPCode2NNN(const WORD& opcode) {
-    // Push current PC onto the stack
-    m_Stack.push(m_ProgramCounter);
+    // Push current PC onto the stack. A call deeper than 16 levels is dropped rather than overflowing.
+    if (m_StackPointer < 16) {
+        m_Stack[m_StackPointer++] = m_ProgramCounter;
+    }
 
     // Extract NNN (lower 12 bits)
     const WORD address = opcode & 0x0FFF;
@@ -477,7 +651,7 @@ void CHIP8Context::OPCode8XY7(const WORD &opcode) {
 /**
 * CHIP8 Instruction 8XYE.
 * @param opcode The OPCode that contains the registers X and Y.
-* @post VX is shifted right 1. Sets VF to the least significant bit pre-shift.
+* @post VX is shifted left 1. Sets VF to the most significant bit pre-shift.
 */
 void CHIP8Context::OPCode8XYE(const WORD &opcode) {
     int x = (opcode & 0x0F00) >> 8;
@@ -509,13 +683,14 @@ void CHIP8Context::OPCodeBNNN(const WORD &opcode) {
 }
 
 void CHIP8Context::OPCodeCXNN(const WORD &opcode) {
-    std::random_device rd;   // Non-deterministic seed
-    std::mt19937 gen(rd());  // Mersenne Twister engine
-    std::uniform_int_distribution<int> dist(0, 255);
+    // xorshift32: cheap, allocation free, and reproducible for a given seed.
+    m_RandomState ^= m_RandomState << 13;
+    m_RandomState ^= m_RandomState >> 17;
+    m_RandomState ^= m_RandomState << 5;
 
     int x = (opcode & 0x0F00) >> 8;
     int NN = opcode & 0x00FF;
-    m_Registers[x] = static_cast<BYTE>(dist(gen) & NN);
+    m_Registers[x] = static_cast<BYTE>(m_RandomState & NN);
 
 }
 
@@ -531,7 +706,7 @@ void CHIP8Context::OPCodeDXYN(const WORD& opcode) {
     m_Registers[0xF] = 0; // reset collision flag
 
     for (int row = 0; row < height; ++row) {
-        BYTE spriteByte = m_GameMemory[m_AddressI + row];
+        BYTE spriteByte = m_GameMemory[(m_AddressI + row) & 0x0FFF];
 
         // Each sprite row is 8 pixels wide, MSB on the left
         for (int bit = 0; bit < 8; ++bit) {
@@ -555,7 +730,7 @@ void CHIP8Context::OPCodeEX9E(const WORD &opcode) {
     int x = (opcode & 0x0F00) >> 8; // extract X
     BYTE key = m_Registers[x] & 0x000F; // lowest nibble
 
-    if (isKeyPressed(key)) {
+    if ((m_Keypad >> key) & 1) {
         m_ProgramCounter += 2; // skip next instruction
     }
 }
@@ -564,7 +739,7 @@ void CHIP8Context::OPCodeEXA1(const WORD &opcode) {
     int x = (opcode & 0x0F00) >> 8;
     BYTE key = m_Registers[x] & 0x000F;
 
-    if (!isKeyPressed(key)) {
+    if (!((m_Keypad >> key) & 1)) {
         m_ProgramCounter +=2;
     }
 }
@@ -572,19 +747,22 @@ void CHIP8Context::OPCodeEXA1(const WORD &opcode) {
 void CHIP8Context::OPCodeFX0A(const WORD &opcode) {
     int x = (opcode & 0x0F00) >> 8;
 
-    bool keyPressed = false;
-    for (int i = 0; i < 16; ++i) {
-        if (m_Keypad[i]) {
-            m_Registers[x] = i;
-            keyPressed = true;
-            break;
-        }
-    }
-
     // If no key is pressed, decrement PC to re-execute this instruction
-    if (!keyPressed) {
+    if (m_Keypad == 0) {
         m_ProgramCounter -= 2;
+        return;
     }
+
+    // The lowest numbered held key wins.
+#if defined(__GNUC__) || defined(__clang__)
+    m_Registers[x] = static_cast<BYTE>(__builtin_ctz(m_Keypad));
+#else
+    BYTE key = 0;
+    while (!((m_Keypad >> key) & 1)) {
+        ++key;
+    }
+    m_Registers[x] = key;
+#endif
 }
 
 void CHIP8Context::OPCodeFX1E(const WORD &opcode) {
@@ -612,28 +790,25 @@ void CHIP8Context::OPCodeFX29(const WORD &opcode) {
     int x = (opcode & 0x0F00) >> 8;
     BYTE digit = m_Registers[x] & 0x0F; // 0..F
 
-    // Standard CHIP-8 fontset base (each glyph 5 bytes)
-    const WORD FONT_BASE = 0x050;
-    const WORD GLYPH_SIZE = 5;
-
-    m_AddressI = static_cast<WORD>(FONT_BASE + static_cast<WORD>(digit) * GLYPH_SIZE);
+    // The glyphs are placed by every reset; see CHIP8BootImage
+    m_AddressI = static_cast<WORD>(CHIP8BootImage::FONT_BASE + static_cast<WORD>(digit) * CHIP8BootImage::GLYPH_SIZE);
 }
 
 void CHIP8Context::OPCodeFX33(const WORD &opcode) {
     int x = (opcode & 0x0F00) >> 8;
     BYTE value = m_Registers[x];
 
-    // Store BCD representation of Vx in memory
-    m_GameMemory[m_AddressI] = value / 100;        // hundreds
-    m_GameMemory[m_AddressI + 1] = (value / 10) % 10;  // tens
-    m_GameMemory[m_AddressI + 2] = value % 10;         // ones
+    // Store BCD representation of Vx in memory. I can point anywhere, so addresses wrap at 4K.
+    m_GameMemory[m_AddressI & 0x0FFF] = value / 100;        // hundreds
+    m_GameMemory[(m_AddressI + 1) & 0x0FFF] = (value / 10) % 10;  // tens
+    m_GameMemory[(m_AddressI + 2) & 0x0FFF] = value % 10;         // ones
 }
 
 void CHIP8Context::OPCodeFX55(const WORD &opcode) {
     int x = (opcode & 0x0F00) >> 8;
 
     for (int i = 0; i <= x; i++) {
-        m_GameMemory[m_AddressI + i] = m_Registers[i];
+        m_GameMemory[(m_AddressI + i) & 0x0FFF] = m_Registers[i];
     }
 }
 
@@ -641,6 +816,6 @@ void CHIP8Context::OPCodeFX65(const WORD &opcode) {
     int x = (opcode & 0x0F00) >> 8;
 
     for (int i = 0; i <= x; i++) {
-        m_Registers[i] = m_GameMemory[m_AddressI + i];
+        m_Registers[i] = m_GameMemory[(m_AddressI + i) & 0x0FFF];
     }
 }
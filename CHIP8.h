@@ -5,14 +5,135 @@
 #ifndef MY_CHIP_8_EMULATOR_CHIP8_H
 #define MY_CHIP_8_EMULATOR_CHIP8_H
 
-#include <vector>
 #include <cstdint>
-#include <iostream>
-#include <limits>
-#include <random>
-#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <sys/types.h>
+#include <type_traits>
+
+/**
+ * A change in keypad state, applied just before the instruction at the given cycle of a batch.
+ */
+struct CHIP8KeyEvent {
+    uint16_t cycle; // index of the instruction within the batch passed to runCycles
+    uint8_t key;    // keypad key 0x0..0xF
+    bool pressed;
+};
+
+/**
+ * Every instruction the interpreter tells apart. Each opcode decodes to exactly one of these.
+ */
+enum class CHIP8Op : uint8_t {
+    INVALID,
+    OP_00E0, OP_00EE, OP_1NNN, OP_2NNN, OP_3XNN, OP_4XNN, OP_5XY0, OP_6XNN, OP_7XNN,
+    OP_8XY0, OP_8XY1, OP_8XY2, OP_8XY3, OP_8XY4, OP_8XY5, OP_8XY6, OP_8XY7, OP_8XYE,
+    OP_9XY0, OP_ANNN, OP_BNNN, OP_CXNN, OP_DXYN, OP_EX9E, OP_EXA1,
+    OP_FX07, OP_FX0A, OP_FX15, OP_FX18, OP_FX1E, OP_FX29, OP_FX33, OP_FX55, OP_FX65,
+    COUNT
+};
 
-#include "SDL2/SDL.h"
+/**
+ * Decodes an opcode the way CHIP8Context::execute does, including its leniencies: 5XY0 and 9XY0 ignore
+ * the low nibble, EX9E/EXA1 look only at the low nibble, and FX29/FX33/FX55/FX65 ignore it.
+ * @param opcode The 16-bit opcode.
+ * @return The instruction, or CHIP8Op::INVALID for opcodes the interpreter treats as no-ops.
+ */
+inline CHIP8Op decodeOpcode(uint16_t opcode) {
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            switch (opcode & 0x0FFF) {
+                case 0x00E0: return CHIP8Op::OP_00E0;
+                case 0x00EE: return CHIP8Op::OP_00EE;
+                default:     return CHIP8Op::INVALID;
+            }
+        case 0x1000: return CHIP8Op::OP_1NNN;
+        case 0x2000: return CHIP8Op::OP_2NNN;
+        case 0x3000: return CHIP8Op::OP_3XNN;
+        case 0x4000: return CHIP8Op::OP_4XNN;
+        case 0x5000: return CHIP8Op::OP_5XY0;
+        case 0x6000: return CHIP8Op::OP_6XNN;
+        case 0x7000: return CHIP8Op::OP_7XNN;
+        case 0x8000:
+            switch (opcode & 0x000F) {
+                case 0x0: return CHIP8Op::OP_8XY0;
+                case 0x1: return CHIP8Op::OP_8XY1;
+                case 0x2: return CHIP8Op::OP_8XY2;
+                case 0x3: return CHIP8Op::OP_8XY3;
+                case 0x4: return CHIP8Op::OP_8XY4;
+                case 0x5: return CHIP8Op::OP_8XY5;
+                case 0x6: return CHIP8Op::OP_8XY6;
+                case 0x7: return CHIP8Op::OP_8XY7;
+                case 0xE: return CHIP8Op::OP_8XYE;
+                default:  return CHIP8Op::INVALID;
+            }
+        case 0x9000: return CHIP8Op::OP_9XY0;
+        case 0xA000: return CHIP8Op::OP_ANNN;
+        case 0xB000: return CHIP8Op::OP_BNNN;
+        case 0xC000: return CHIP8Op::OP_CXNN;
+        case 0xD000: return CHIP8Op::OP_DXYN;
+        case 0xE000:
+            switch (opcode & 0x000F) {
+                case 0xE: return CHIP8Op::OP_EX9E;
+                case 0x1: return CHIP8Op::OP_EXA1;
+                default:  return CHIP8Op::INVALID;
+            }
+        default: // 0xF000
+            switch (opcode & 0x00F0) {
+                case 0x00:
+                    switch (opcode & 0x000F) {
+                        case 0x7: return CHIP8Op::OP_FX07;
+                        case 0xA: return CHIP8Op::OP_FX0A;
+                        default:  return CHIP8Op::INVALID;
+                    }
+                case 0x10:
+                    switch (opcode & 0x000F) {
+                        case 0x5: return CHIP8Op::OP_FX15;
+                        case 0x8: return CHIP8Op::OP_FX18;
+                        case 0xE: return CHIP8Op::OP_FX1E;
+                        default:  return CHIP8Op::INVALID;
+                    }
+                case 0x20: return CHIP8Op::OP_FX29;
+                case 0x30: return CHIP8Op::OP_FX33;
+                case 0x50: return CHIP8Op::OP_FX55;
+                case 0x60: return CHIP8Op::OP_FX65;
+                default:   return CHIP8Op::INVALID;
+            }
+    }
+}
+
+/**
+ * Predecoded instructions for a loaded ROM, indexed by address. Built by CHIP8Analyzer from the
+ * reachable code and used by CHIP8Context::runCyclesPredecoded. A machine stops using its map as
+ * soon as it writes over an address the map decoded, so self-modifying code stays correct.
+ */
+struct CHIP8BlockMap {
+    struct Entry {
+        uint16_t m_Opcode;
+        CHIP8Op m_Op;
+        bool m_Decoded; // false for addresses the analysis never reached; those are decoded at run time
+    };
+    Entry m_Entries[0x1000];
+    uint64_t m_Id = 0; // unique per buildBlockMap call, so a machine can tell whether the map is its own
+
+    /**
+     * @post No address is predecoded.
+     */
+    void clear() {
+        for (Entry& entry : m_Entries) {
+            entry = Entry{0, CHIP8Op::INVALID, false};
+        }
+    }
+
+    /**
+     * @return true if the byte at address belongs to a predecoded instruction.
+     */
+    bool coversByte(uint16_t address) const {
+        return m_Entries[address & 0x0FFF].m_Decoded || m_Entries[(address - 1) & 0x0FFF].m_Decoded;
+    }
+};
+
+class CHIP8BootImage;
 
 struct CHIP8Context {
     // typedef unsigned char WORD;
@@ -21,25 +142,110 @@ struct CHIP8Context {
     using BYTE = u_int8_t;
     using WORD = u_int16_t;
 
-    BYTE m_GameMemory[0xFFF]; // 0xFFF bytes of memory
+    BYTE m_GameMemory[0x1000]; // 4 KB of memory, 0x000..0xFFF
     BYTE m_Registers[16]; // 16 registers, 1 byte each
     WORD m_AddressI; // The 16-bit address register I
     WORD m_ProgramCounter; // the 16-bit program counter
-    std::stack<uint16_t> m_Stack; // the 16-bit stack
-    BYTE m_Keypad[16];
+    WORD m_Stack[16]; // the 16-bit stack, fixed depth so the context never allocates
+    BYTE m_StackPointer;
+    uint16_t m_Keypad; // bit N set means key N is held
     BYTE m_ScreenData[64][32];
     BYTE m_DelayTimer;
     BYTE m_SoundTimer;
+    uint32_t m_RandomState; // xorshift32 state used by CXNN
+    // m_Id of the CHIP8BlockMap describing this machine's code, or 0. Only runCyclesPredecoded keeps it
+    // up to date; the plain loops clear it, as must anything else that writes m_GameMemory. An id rather
+    // than a pointer, so a machine never holds on to a map it does not own. Not part of the machine state.
+    uint64_t m_BlockMapId;
 
-    void CPUReset();
+    /**
+     * Resets the machine to a boot image with a fresh random seed.
+     * @param image The ROM to start, as built by CHIP8BootImage.
+     */
+    void CPUReset(const CHIP8BootImage& image);
     void execute();
+
+    /**
+     * Runs one already decoded instruction. PC has already been advanced past it.
+     * @param op The decoded instruction.
+     * @param opcode The opcode it was decoded from, for its operands.
+     */
+    void dispatch(CHIP8Op op, WORD opcode);
     WORD GetNextOpcode();
 
+    /**
+     * Clears registers, timers, keypad and screen, and resets memory to zeroes plus the font, without loading a ROM.
+     */
+    void resetState();
+
+    /**
+     * Copies a ROM into memory at 0x200.
+     * @param rom The ROM contents.
+     * @param size The size of the ROM in bytes.
+     * @return The number of bytes loaded. ROMs larger than the 0xE00 bytes available are truncated.
+     */
+    size_t loadROM(const BYTE* rom, size_t size);
+
+    /**
+     * Seeds the random number generator used by CXNN.
+     * @param seed Any value. Zero is remapped since xorshift cannot leave the zero state.
+     */
+    void seedRandom(uint32_t seed);
+
+    /**
+     * Runs a number of instructions, ticking the timers after each one.
+     * @param count The number of instructions to execute.
+     */
+    void runCycles(int count);
+
+    /**
+     * Runs a number of instructions, applying key events at the cycle they were timestamped with.
+     * @param count The number of instructions to execute.
+     * @param events Key events sorted by cycle. Events at or past count are applied after the last instruction.
+     * @param eventCount The number of events.
+     */
+    void runCycles(int count, const CHIP8KeyEvent* events, size_t eventCount);
+
+    /**
+     * runCycles for a machine booted from a predecoded CHIP8BootImage: instructions the map decoded
+     * skip the fetch and the decode. A separate loop, so execute() and runCycles pay nothing for it.
+     * Falls back to runCycles if map is not the machine's own, or stops using it once the machine
+     * writes over its own code.
+     * @param map The boot image's block map; see CHIP8BootImage::blockMap().
+     * @param count The number of instructions to execute.
+     * @param events Key events sorted by cycle, as for runCycles.
+     * @param eventCount The number of events.
+     */
+    void runCyclesPredecoded(const CHIP8BlockMap& map, int count, const CHIP8KeyEvent* events = nullptr,
+                             size_t eventCount = 0);
+
+    /**
+     * @param event The key event to apply.
+     * @post The key's bit in m_Keypad is set or cleared.
+     */
+    void applyKeyEvent(const CHIP8KeyEvent& event);
+
+    /**
+     * @post The delay and sound timers are decremented if they are above zero.
+     */
+    void tickTimers();
+
+    /**
+     * @return A 64-bit hash of everything that affects future execution: memory, registers, I, PC,
+     * the live part of the stack, timers, keypad, screen and random state. Padding is never hashed,
+     * so equal machines always hash equal.
+     */
+    uint64_t stateHash() const;
+
 
     // Helper functions
     bool isKeyPressed(const BYTE& key) const;
-    void render(SDL_Renderer* renderer);
-    void processInput(CHIP8Context& chip8, SDL_Event& e, bool& running);
+
+    /**
+     * Runs one instruction through map, which must be the machine's own.
+     * @post m_BlockMapId is 0 if the instruction wrote over a predecoded byte.
+     */
+    void executePredecoded(const CHIP8BlockMap& map);
 
     // OPCodes
 
@@ -163,7 +369,7 @@ struct CHIP8Context {
     /**
      * CHIP8 Instruction 8XYE.
      * @param opcode The OPCode that contains the registers X and Y.
-     * @post VX is shifted right 1. Sets VF to the least significant bit pre-shift.
+     * @post VX is shifted left 1. Sets VF to the most significant bit pre-shift.
      */
     void OPCode8XYE(const WORD& opcode);
 
@@ -207,16 +413,14 @@ struct CHIP8Context {
     /**
      * CHIP8 Instruction EX9E.
      * @param opcode An OPCode containing a number X corresponding to the requested register.
-     * @post Draws a sprite at coordinate (VX, VY) that has a width of 8 pixels and a height of N pixels.
-     * VF is set to 1 if any screen pixels are flipped from set to unset when the sprite is drawn,
-     * and to 0 if that does not happen.
+     * @post Skips the next instruction if the key corresponding to the value of VX is pressed.
      */
     void OPCodeEX9E(const WORD& opcode);
 
     /**
      * CHIP8 Instruction EXA1.
      * @param opcode An OPCode containing a number X corresponding to the requested register.
-     * @post Skips the next instruction if the key corresponding to the value of VX is pressed.
+     * @post Skips the next instruction if the key corresponding to the value of VX is not pressed.
      */
     void OPCodeEXA1(const WORD& opcode);
 
@@ -290,5 +494,9 @@ struct CHIP8Context {
 
 };
 
+// Snapshots (run-ahead, rollback, state search) are plain copies of the context, so it must stay free of
+// pointers to owned memory and of non-trivial members.
+static_assert(std::is_trivially_copyable<CHIP8Context>::value, "CHIP8Context must be trivially copyable");
+
 
 #endif //MY_CHIP_8_EMULATOR_CHIP8_H
@@ -0,0 +1,449 @@
+//
+// Static ROM analysis. See CHIP8Analyzer.h.
+//
+#include "CHIP8Analyzer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+constexpr uint8_t CHIP8Analysis::INSTRUCTION_START;
+constexpr uint8_t CHIP8Analysis::CODE_BYTE;
+
+namespace {
+    bool isSkip(CHIP8Op op) {
+        return op == CHIP8Op::OP_3XNN || op == CHIP8Op::OP_4XNN || op == CHIP8Op::OP_5XY0 ||
+               op == CHIP8Op::OP_9XY0 || op == CHIP8Op::OP_EX9E || op == CHIP8Op::OP_EXA1;
+    }
+
+    bool endsBlock(CHIP8Op op) {
+        return isSkip(op) || op == CHIP8Op::OP_00EE || op == CHIP8Op::OP_1NNN || op == CHIP8Op::OP_2NNN ||
+               op == CHIP8Op::OP_BNNN || op == CHIP8Op::INVALID;
+    }
+
+    struct MemoryWrite {
+        uint16_t m_Instruction;
+        uint16_t m_Start;
+        uint8_t m_Length;
+        bool m_Known;
+    };
+
+    // Walks every path from the entry point, marking instructions and block leaders.
+    struct Explorer {
+        CHIP8Analysis& m_Analysis;
+        bool m_Leader[0x1000] = {};
+        bool m_Function[0x1000] = {};
+        std::vector<uint16_t> m_Work;
+        std::vector<MemoryWrite> m_Writes;
+
+        explicit Explorer(CHIP8Analysis& analysis) : m_Analysis(analysis) {}
+
+        bool inRom(uint16_t address) const {
+            return address >= m_Analysis.m_RomStart && address < m_Analysis.m_RomEnd;
+        }
+
+        void addFinding(CHIP8FindingKind kind, uint16_t address, uint16_t end, uint16_t target) {
+            m_Analysis.m_Findings.push_back(CHIP8Finding{kind, address, end, target});
+        }
+
+        void addTarget(uint16_t from, uint16_t to) {
+            to &= 0x0FFF;
+            if (!inRom(to)) {
+                addFinding(CHIP8FindingKind::OUTSIDE_ROM, from, static_cast<uint16_t>(from + 2), to);
+            }
+            m_Leader[to] = true;
+            m_Work.push_back(to);
+        }
+
+        void run() {
+            m_Function[0x200] = true;
+            addTarget(0x200, 0x200);
+            while (!m_Work.empty()) {
+                const uint16_t start = m_Work.back();
+                m_Work.pop_back();
+                walk(start);
+            }
+        }
+
+        void walk(uint16_t address) {
+            // I is only known until the next join; a value from one predecessor says nothing about another.
+            bool knownI = false;
+            uint16_t addressI = 0;
+            uint8_t* flags = m_Analysis.m_Flags;
+
+            while (!(flags[address] & CHIP8Analysis::INSTRUCTION_START)) {
+                flags[address] |= CHIP8Analysis::INSTRUCTION_START | CHIP8Analysis::CODE_BYTE;
+                flags[(address + 1) & 0x0FFF] |= CHIP8Analysis::CODE_BYTE;
+
+                const uint16_t opcode = m_Analysis.opcodeAt(address);
+                const CHIP8Op op = decodeOpcode(opcode);
+                const uint16_t NNN = opcode & 0x0FFF;
+                const int x = (opcode & 0x0F00) >> 8;
+                const uint16_t next = (address + 2) & 0x0FFF;
+
+                switch (op) {
+                    case CHIP8Op::INVALID:
+                        addFinding(CHIP8FindingKind::INVALID_OPCODE, address, static_cast<uint16_t>(address + 2), opcode);
+                        return;
+                    case CHIP8Op::OP_00EE:
+                        return;
+                    case CHIP8Op::OP_1NNN:
+                        addTarget(address, NNN);
+                        return;
+                    case CHIP8Op::OP_2NNN:
+                        m_Function[NNN] = true;
+                        addTarget(address, NNN);
+                        addTarget(address, next);
+                        return;
+                    case CHIP8Op::OP_BNNN:
+                        addFinding(CHIP8FindingKind::COMPUTED_JUMP, address, static_cast<uint16_t>(address + 2), NNN);
+                        return;
+                    case CHIP8Op::OP_ANNN:
+                        knownI = true;
+                        addressI = NNN;
+                        break;
+                    case CHIP8Op::OP_FX1E:
+                    case CHIP8Op::OP_FX29:
+                        knownI = false;
+                        break;
+                    case CHIP8Op::OP_FX33:
+                        m_Writes.push_back(MemoryWrite{address, addressI, 3, knownI});
+                        break;
+                    case CHIP8Op::OP_FX55:
+                        m_Writes.push_back(MemoryWrite{address, addressI, static_cast<uint8_t>(x + 1), knownI});
+                        break;
+                    default:
+                        break;
+                }
+
+                if (isSkip(op)) {
+                    addTarget(address, next);
+                    addTarget(address, static_cast<uint16_t>(address + 4));
+                    return;
+                }
+                if (!inRom(next)) {
+                    addFinding(CHIP8FindingKind::OUTSIDE_ROM, address, static_cast<uint16_t>(address + 2), next);
+                }
+                if (next < address) {
+                    m_Leader[next] = true; // blocks never wrap around the end of memory
+                }
+                address = next;
+            }
+
+            // Fell through into code that was already walked: that instruction starts a block.
+            m_Leader[address] = true;
+        }
+    };
+
+    void buildBlocks(CHIP8Analysis& analysis, const Explorer& explorer) {
+        for (int start = 0; start < 0x1000; ++start) {
+            if (!explorer.m_Leader[start] || !(analysis.m_Flags[start] & CHIP8Analysis::INSTRUCTION_START)) {
+                continue;
+            }
+
+            CHIP8BasicBlock block{};
+            block.m_Start = static_cast<uint16_t>(start);
+            uint16_t address = block.m_Start;
+            while (true) {
+                const uint16_t opcode = analysis.opcodeAt(address);
+                const CHIP8Op op = decodeOpcode(opcode);
+                const uint16_t next = (address + 2) & 0x0FFF;
+
+                if (endsBlock(op)) {
+                    block.m_End = static_cast<uint16_t>(address + 2);
+                    if (isSkip(op)) {
+                        block.m_Successors.push_back(next);
+                        block.m_Successors.push_back((address + 4) & 0x0FFF);
+                    } else if (op == CHIP8Op::OP_1NNN) {
+                        block.m_Successors.push_back(opcode & 0x0FFF);
+                    } else if (op == CHIP8Op::OP_2NNN) {
+                        block.m_Successors.push_back(next);
+                        block.m_Callee = opcode & 0x0FFF;
+                        block.m_EndsInCall = true;
+                    }
+                    block.m_Returns = op == CHIP8Op::OP_00EE;
+                    block.m_ComputedJump = op == CHIP8Op::OP_BNNN;
+                    break;
+                }
+                if (explorer.m_Leader[next] || !(analysis.m_Flags[next] & CHIP8Analysis::INSTRUCTION_START)) {
+                    block.m_End = static_cast<uint16_t>(address + 2);
+                    if (analysis.m_Flags[next] & CHIP8Analysis::INSTRUCTION_START) {
+                        block.m_Successors.push_back(next);
+                    }
+                    break;
+                }
+                address = next;
+            }
+            analysis.m_Blocks.push_back(std::move(block));
+        }
+    }
+
+    void buildFunctions(CHIP8Analysis& analysis, const Explorer& explorer) {
+        std::vector<int> blockAt(0x1000, -1);
+        for (size_t i = 0; i < analysis.m_Blocks.size(); ++i) {
+            blockAt[analysis.m_Blocks[i].m_Start] = static_cast<int>(i);
+        }
+
+        // The entry point first, then call targets in address order.
+        std::vector<uint16_t> entries(1, 0x200);
+        for (int address = 0; address < 0x1000; ++address) {
+            if (explorer.m_Function[address] && address != 0x200) {
+                entries.push_back(static_cast<uint16_t>(address));
+            }
+        }
+
+        std::vector<bool> seen(analysis.m_Blocks.size());
+        std::vector<int> pending;
+        for (uint16_t entry : entries) {
+            CHIP8Function function;
+            function.m_Entry = entry;
+            std::fill(seen.begin(), seen.end(), false);
+
+            if (blockAt[entry] >= 0) {
+                pending.push_back(blockAt[entry]);
+                seen[blockAt[entry]] = true;
+            }
+            while (!pending.empty()) {
+                const CHIP8BasicBlock& block = analysis.m_Blocks[pending.back()];
+                pending.pop_back();
+                function.m_Blocks.push_back(block.m_Start);
+                if (block.m_EndsInCall) {
+                    function.m_Callees.push_back(block.m_Callee);
+                }
+                for (uint16_t successor : block.m_Successors) {
+                    const int index = blockAt[successor];
+                    if (index >= 0 && !seen[index]) {
+                        seen[index] = true;
+                        pending.push_back(index);
+                    }
+                }
+            }
+
+            std::sort(function.m_Blocks.begin(), function.m_Blocks.end());
+            std::sort(function.m_Callees.begin(), function.m_Callees.end());
+            function.m_Callees.erase(std::unique(function.m_Callees.begin(), function.m_Callees.end()),
+                                     function.m_Callees.end());
+            analysis.m_Functions.push_back(std::move(function));
+        }
+    }
+
+    void checkWrites(CHIP8Analysis& analysis, const Explorer& explorer) {
+        for (const MemoryWrite& write : explorer.m_Writes) {
+            const uint16_t end = static_cast<uint16_t>(write.m_Instruction + 2);
+            if (!write.m_Known) {
+                analysis.m_Findings.push_back(CHIP8Finding{CHIP8FindingKind::UNKNOWN_WRITE, write.m_Instruction, end, 0});
+                continue;
+            }
+            for (int i = 0; i < write.m_Length; ++i) {
+                if (analysis.m_Flags[(write.m_Start + i) & 0x0FFF] & CHIP8Analysis::CODE_BYTE) {
+                    analysis.m_Findings.push_back(CHIP8Finding{CHIP8FindingKind::SELF_MODIFYING_WRITE,
+                                                               write.m_Instruction, end, write.m_Start});
+                    break;
+                }
+            }
+        }
+    }
+
+    // Unreached bytes are data unless they read as a long run of valid instructions.
+    void findRegions(CHIP8Analysis& analysis) {
+        const int MIN_CODE_WORDS = 4;
+        int address = analysis.m_RomStart;
+        while (address < analysis.m_RomEnd) {
+            if (analysis.m_Flags[address] & CHIP8Analysis::CODE_BYTE) {
+                ++address;
+                continue;
+            }
+
+            const int start = address;
+            while (address < analysis.m_RomEnd && !(analysis.m_Flags[address] & CHIP8Analysis::CODE_BYTE)) {
+                ++address;
+            }
+
+            const int words = (address - start) / 2;
+            bool decodes = words >= MIN_CODE_WORDS;
+            for (int i = 0; decodes && i < words; ++i) {
+                decodes = decodeOpcode(analysis.opcodeAt(static_cast<uint16_t>(start + 2 * i))) != CHIP8Op::INVALID;
+            }
+            analysis.m_Findings.push_back(CHIP8Finding{
+                decodes ? CHIP8FindingKind::UNREACHABLE_CODE : CHIP8FindingKind::DATA_REGION,
+                static_cast<uint16_t>(start), static_cast<uint16_t>(address), 0});
+        }
+    }
+}
+
+CHIP8Analysis analyzeMemory(const uint8_t* memory, size_t romSize) {
+    CHIP8Analysis analysis;
+    std::memcpy(analysis.m_Memory, memory, sizeof(analysis.m_Memory));
+    std::memset(analysis.m_Flags, 0, sizeof(analysis.m_Flags));
+    analysis.m_RomEnd = static_cast<uint16_t>(0x200 + std::min<size_t>(romSize, 0x1000 - 0x200));
+
+    Explorer explorer(analysis);
+    explorer.run();
+    buildBlocks(analysis, explorer);
+    buildFunctions(analysis, explorer);
+    checkWrites(analysis, explorer);
+    findRegions(analysis);
+
+    // A target can be reported by several paths; keep one finding per kind and address.
+    auto& findings = analysis.m_Findings;
+    std::stable_sort(findings.begin(), findings.end(), [](const CHIP8Finding& a, const CHIP8Finding& b) {
+        return a.m_Address != b.m_Address ? a.m_Address < b.m_Address : a.m_Kind < b.m_Kind;
+    });
+    findings.erase(std::unique(findings.begin(), findings.end(), [](const CHIP8Finding& a, const CHIP8Finding& b) {
+        return a.m_Address == b.m_Address && a.m_Kind == b.m_Kind && a.m_Target == b.m_Target;
+    }), findings.end());
+
+    return analysis;
+}
+
+void buildBlockMap(const CHIP8Analysis& analysis, CHIP8BlockMap& map) {
+    static std::atomic<uint64_t> builds{0};
+    map.clear();
+    map.m_Id = ++builds;
+    for (int address = 0; address < 0x1000; ++address) {
+        if (analysis.m_Flags[address] & CHIP8Analysis::INSTRUCTION_START) {
+            const uint16_t opcode = analysis.opcodeAt(static_cast<uint16_t>(address));
+            map.m_Entries[address] = CHIP8BlockMap::Entry{opcode, decodeOpcode(opcode), true};
+        }
+    }
+}
+
+void formatInstruction(uint16_t opcode, char* out, size_t size) {
+    const int x = (opcode & 0x0F00) >> 8;
+    const int y = (opcode & 0x00F0) >> 4;
+    const int N = opcode & 0x000F;
+    const int NN = opcode & 0x00FF;
+    const int NNN = opcode & 0x0FFF;
+
+    switch (decodeOpcode(opcode)) {
+        case CHIP8Op::OP_00E0: std::snprintf(out, size, "CLS"); break;
+        case CHIP8Op::OP_00EE: std::snprintf(out, size, "RET"); break;
+        case CHIP8Op::OP_1NNN: std::snprintf(out, size, "JP 0x%03X", NNN); break;
+        case CHIP8Op::OP_2NNN: std::snprintf(out, size, "CALL 0x%03X", NNN); break;
+        case CHIP8Op::OP_3XNN: std::snprintf(out, size, "SE V%X, 0x%02X", x, NN); break;
+        case CHIP8Op::OP_4XNN: std::snprintf(out, size, "SNE V%X, 0x%02X", x, NN); break;
+        case CHIP8Op::OP_5XY0: std::snprintf(out, size, "SE V%X, V%X", x, y); break;
+        case CHIP8Op::OP_6XNN: std::snprintf(out, size, "LD V%X, 0x%02X", x, NN); break;
+        case CHIP8Op::OP_7XNN: std::snprintf(out, size, "ADD V%X, 0x%02X", x, NN); break;
+        case CHIP8Op::OP_8XY0: std::snprintf(out, size, "LD V%X, V%X", x, y); break;
+        case CHIP8Op::OP_8XY1: std::snprintf(out, size, "OR V%X, V%X", x, y); break;
+        case CHIP8Op::OP_8XY2: std::snprintf(out, size, "AND V%X, V%X", x, y); break;
+        case CHIP8Op::OP_8XY3: std::snprintf(out, size, "XOR V%X, V%X", x, y); break;
+        case CHIP8Op::OP_8XY4: std::snprintf(out, size, "ADD V%X, V%X", x, y); break;
+        case CHIP8Op::OP_8XY5: std::snprintf(out, size, "SUB V%X, V%X", x, y); break;
+        case CHIP8Op::OP_8XY6: std::snprintf(out, size, "SHR V%X", x); break;
+        case CHIP8Op::OP_8XY7: std::snprintf(out, size, "SUBN V%X, V%X", x, y); break;
+        case CHIP8Op::OP_8XYE: std::snprintf(out, size, "SHL V%X", x); break;
+        case CHIP8Op::OP_9XY0: std::snprintf(out, size, "SNE V%X, V%X", x, y); break;
+        case CHIP8Op::OP_ANNN: std::snprintf(out, size, "LD I, 0x%03X", NNN); break;
+        case CHIP8Op::OP_BNNN: std::snprintf(out, size, "JP V0, 0x%03X", NNN); break;
+        case CHIP8Op::OP_CXNN: std::snprintf(out, size, "RND V%X, 0x%02X", x, NN); break;
+        case CHIP8Op::OP_DXYN: std::snprintf(out, size, "DRW V%X, V%X, %d", x, y, N); break;
+        case CHIP8Op::OP_EX9E: std::snprintf(out, size, "SKP V%X", x); break;
+        case CHIP8Op::OP_EXA1: std::snprintf(out, size, "SKNP V%X", x); break;
+        case CHIP8Op::OP_FX07: std::snprintf(out, size, "LD V%X, DT", x); break;
+        case CHIP8Op::OP_FX0A: std::snprintf(out, size, "LD V%X, K", x); break;
+        case CHIP8Op::OP_FX15: std::snprintf(out, size, "LD DT, V%X", x); break;
+        case CHIP8Op::OP_FX18: std::snprintf(out, size, "LD ST, V%X", x); break;
+        case CHIP8Op::OP_FX1E: std::snprintf(out, size, "ADD I, V%X", x); break;
+        case CHIP8Op::OP_FX29: std::snprintf(out, size, "LD F, V%X", x); break;
+        case CHIP8Op::OP_FX33: std::snprintf(out, size, "LD B, V%X", x); break;
+        case CHIP8Op::OP_FX55: std::snprintf(out, size, "LD [I], V%X", x); break;
+        case CHIP8Op::OP_FX65: std::snprintf(out, size, "LD V%X, [I]", x); break;
+        default:               std::snprintf(out, size, "DW 0x%04X", opcode); break;
+    }
+}
+
+const char* findingName(CHIP8FindingKind kind) {
+    switch (kind) {
+        case CHIP8FindingKind::DATA_REGION:          return "data";
+        case CHIP8FindingKind::UNREACHABLE_CODE:     return "unreachable-code";
+        case CHIP8FindingKind::SELF_MODIFYING_WRITE: return "self-modifying-write";
+        case CHIP8FindingKind::UNKNOWN_WRITE:        return "unknown-write";
+        case CHIP8FindingKind::COMPUTED_JUMP:        return "computed-jump";
+        case CHIP8FindingKind::INVALID_OPCODE:       return "invalid-opcode";
+        case CHIP8FindingKind::OUTSIDE_ROM:          return "outside-rom";
+    }
+    return "unknown";
+}
+
+void writeAnalysisDot(const CHIP8Analysis& analysis, FILE* out) {
+    std::fprintf(out, "digraph chip8 {\n");
+    std::fprintf(out, "    node [shape=box, fontname=\"monospace\"];\n");
+
+    char text[32];
+    for (const CHIP8BasicBlock& block : analysis.m_Blocks) {
+        std::fprintf(out, "    b%03X [label=\"", block.m_Start);
+        for (uint16_t address = block.m_Start; address < block.m_End; address = static_cast<uint16_t>(address + 2)) {
+            const uint16_t opcode = analysis.opcodeAt(address);
+            formatInstruction(opcode, text, sizeof(text));
+            std::fprintf(out, "%03X  %04X  %s\\l", address & 0x0FFF, opcode, text);
+        }
+        std::fprintf(out, "\"%s];\n", block.m_ComputedJump ? ", color=red" : "");
+    }
+
+    for (const CHIP8BasicBlock& block : analysis.m_Blocks) {
+        for (uint16_t successor : block.m_Successors) {
+            std::fprintf(out, "    b%03X -> b%03X;\n", block.m_Start, successor);
+        }
+        if (block.m_EndsInCall) {
+            std::fprintf(out, "    b%03X -> b%03X [style=dashed, label=\"call\"];\n", block.m_Start, block.m_Callee);
+        }
+    }
+    std::fprintf(out, "}\n");
+}
+
+namespace {
+    void writeAddressList(FILE* out, const std::vector<uint16_t>& addresses) {
+        std::fprintf(out, "[");
+        for (size_t i = 0; i < addresses.size(); ++i) {
+            std::fprintf(out, "%s%u", i ? ", " : "", addresses[i]);
+        }
+        std::fprintf(out, "]");
+    }
+}
+
+void writeAnalysisJson(const CHIP8Analysis& analysis, FILE* out) {
+    std::fprintf(out, "{\n  \"rom\": {\"start\": %u, \"end\": %u},\n", analysis.m_RomStart, analysis.m_RomEnd);
+
+    char text[32];
+    std::fprintf(out, "  \"blocks\": [\n");
+    for (size_t i = 0; i < analysis.m_Blocks.size(); ++i) {
+        const CHIP8BasicBlock& block = analysis.m_Blocks[i];
+        std::fprintf(out, "    {\"start\": %u, \"end\": %u, \"successors\": ", block.m_Start, block.m_End);
+        writeAddressList(out, block.m_Successors);
+        if (block.m_EndsInCall) {
+            std::fprintf(out, ", \"call\": %u", block.m_Callee);
+        }
+        std::fprintf(out, ", \"returns\": %s, \"computedJump\": %s, \"instructions\": [",
+                     block.m_Returns ? "true" : "false", block.m_ComputedJump ? "true" : "false");
+        for (uint16_t address = block.m_Start; address < block.m_End; address = static_cast<uint16_t>(address + 2)) {
+            const uint16_t opcode = analysis.opcodeAt(address);
+            formatInstruction(opcode, text, sizeof(text));
+            std::fprintf(out, "%s{\"address\": %u, \"opcode\": %u, \"text\": \"%s\"}",
+                         address == block.m_Start ? "" : ", ", address & 0x0FFF, opcode, text);
+        }
+        std::fprintf(out, "]}%s\n", i + 1 < analysis.m_Blocks.size() ? "," : "");
+    }
+    std::fprintf(out, "  ],\n");
+
+    std::fprintf(out, "  \"functions\": [\n");
+    for (size_t i = 0; i < analysis.m_Functions.size(); ++i) {
+        const CHIP8Function& function = analysis.m_Functions[i];
+        std::fprintf(out, "    {\"entry\": %u, \"blocks\": ", function.m_Entry);
+        writeAddressList(out, function.m_Blocks);
+        std::fprintf(out, ", \"callees\": ");
+        writeAddressList(out, function.m_Callees);
+        std::fprintf(out, "}%s\n", i + 1 < analysis.m_Functions.size() ? "," : "");
+    }
+    std::fprintf(out, "  ],\n");
+
+    std::fprintf(out, "  \"findings\": [\n");
+    for (size_t i = 0; i < analysis.m_Findings.size(); ++i) {
+        const CHIP8Finding& finding = analysis.m_Findings[i];
+        std::fprintf(out, "    {\"kind\": \"%s\", \"start\": %u, \"end\": %u, \"target\": %u}%s\n",
+                     findingName(finding.m_Kind), finding.m_Address, finding.m_End, finding.m_Target,
+                     i + 1 < analysis.m_Findings.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
@@ -0,0 +1,111 @@
+//
+// Static analysis of ROMs: disassembly, basic blocks, control-flow and call graphs, and findings such as
+// data regions and self-modifying writes. The result can be turned into a CHIP8BlockMap for the interpreter.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_CHIP8ANALYZER_H
+#define MY_CHIP_8_EMULATOR_CHIP8ANALYZER_H
+
+#include "CHIP8.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/**
+ * A run of instructions with a single entry and a single exit.
+ */
+struct CHIP8BasicBlock {
+    uint16_t m_Start;
+    uint16_t m_End; // address just past the last instruction
+    std::vector<uint16_t> m_Successors; // starts of the blocks control can continue to; calls are not included
+    uint16_t m_Callee;      // target of the 2NNN that ends the block, if m_EndsInCall
+    bool m_EndsInCall;
+    bool m_Returns;         // ends in 00EE
+    bool m_ComputedJump;    // ends in BNNN, so its successors are unknown
+};
+
+/**
+ * A call target (or the ROM entry point) and everything reachable from it without following calls.
+ */
+struct CHIP8Function {
+    uint16_t m_Entry;
+    std::vector<uint16_t> m_Blocks;  // block starts, ascending
+    std::vector<uint16_t> m_Callees; // function entries called from this function, ascending
+};
+
+enum class CHIP8FindingKind : uint8_t {
+    DATA_REGION,          // ROM bytes never reached as code
+    UNREACHABLE_CODE,     // unreached ROM bytes that decode as a run of valid instructions
+    SELF_MODIFYING_WRITE, // FX33/FX55 writing over reachable code
+    UNKNOWN_WRITE,        // FX33/FX55 where I could not be determined
+    COMPUTED_JUMP,        // BNNN: the target depends on V0
+    INVALID_OPCODE,       // reachable opcode the interpreter ignores; analysis stops there
+    OUTSIDE_ROM           // control reaches an address outside the loaded ROM
+};
+
+struct CHIP8Finding {
+    CHIP8FindingKind m_Kind;
+    uint16_t m_Address; // the instruction, or the first byte of a region
+    uint16_t m_End;     // just past the region; m_Address + 2 for single instructions
+    uint16_t m_Target;  // the written or jumped-to address, where one applies
+};
+
+struct CHIP8Analysis {
+    static constexpr uint8_t INSTRUCTION_START = 1; // an instruction is decoded at this address
+    static constexpr uint8_t CODE_BYTE = 2;         // byte belongs to a reachable instruction
+
+    uint16_t m_RomStart = 0x200;
+    uint16_t m_RomEnd = 0x200;
+    uint8_t m_Memory[0x1000];  // the image that was analyzed
+    uint8_t m_Flags[0x1000];   // INSTRUCTION_START and CODE_BYTE per address
+    std::vector<CHIP8BasicBlock> m_Blocks;   // ascending by start
+    std::vector<CHIP8Function> m_Functions;  // ascending by entry; the first is the ROM entry point
+    std::vector<CHIP8Finding> m_Findings;    // ascending by address
+
+    uint16_t opcodeAt(uint16_t address) const {
+        return static_cast<uint16_t>((m_Memory[address & 0x0FFF] << 8) | m_Memory[(address + 1) & 0x0FFF]);
+    }
+};
+
+/**
+ * Disassembles and analyzes a memory image, following every path from 0x200 through jumps, calls and skips.
+ * I is tracked through straight-line code only, so writes after a join or FX1E are reported as unknown.
+ * @param memory 4K of memory with the ROM loaded at 0x200.
+ * @param romSize The number of ROM bytes, used to tell code from data and to flag jumps outside the ROM.
+ * @return The blocks, functions and findings.
+ */
+CHIP8Analysis analyzeMemory(const uint8_t* memory, size_t romSize);
+
+/**
+ * Fills a block map with the decoded instruction at every reachable address.
+ * @param analysis The analysis of the ROM.
+ * @param map Receives the decoded instructions. Unreached addresses are left undecoded.
+ * Invalid opcodes are included too: they decode to CHIP8Op::INVALID and run as no-ops either way.
+ */
+void buildBlockMap(const CHIP8Analysis& analysis, CHIP8BlockMap& map);
+
+/**
+ * Formats an instruction in the usual assembler syntax, e.g. "LD VA, 0x02".
+ */
+void formatInstruction(uint16_t opcode, char* out, size_t size);
+
+/**
+ * @return A short lower-case name for a finding kind, e.g. "self-modifying-write".
+ */
+const char* findingName(CHIP8FindingKind kind);
+
+/**
+ * Writes the control-flow graph as Graphviz DOT: one node per block with its disassembly, solid edges
+ * for control flow and dashed edges for calls.
+ */
+void writeAnalysisDot(const CHIP8Analysis& analysis, FILE* out);
+
+/**
+ * Writes blocks, functions and findings as JSON. Addresses are plain numbers.
+ */
+void writeAnalysisJson(const CHIP8Analysis& analysis, FILE* out);
+
+
+#endif //MY_CHIP_8_EMULATOR_CHIP8ANALYZER_H
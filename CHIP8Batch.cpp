@@ -0,0 +1,579 @@
+//
+// Batched CHIP-8 interpreter: N machines stored as structure-of-arrays and run in lockstep.
+//
+#include "CHIP8Batch.h"
+#include "CHIP8.h"
+#include "CHIP8BootImage.h"
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <cstring>
+
+constexpr int CHIP8Batch::MEMORY_SIZE;
+constexpr int CHIP8Batch::MEMORY_STRIDE;
+constexpr int CHIP8Batch::STACK_DEPTH;
+constexpr int CHIP8Batch::SCREEN_ROWS;
+constexpr int CHIP8Batch::INSTRUCTIONS_PER_FRAME;
+constexpr int CHIP8Batch::WARP_SIZE;
+constexpr int CHIP8Batch::MIN_GROUP_SIZE;
+
+static_assert(CHIP8Batch::WARP_SIZE <= 32, "warp lanes are tracked in a 32-bit mask");
+
+namespace {
+    // xorshift32, one independent stream per lane.
+    inline uint32_t nextRandom(uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Lanes begin..end-1 of a uniform warp. Iterates like a plain counted loop, so the loops over it vectorize.
+    struct LaneRange {
+        struct Iterator {
+            std::size_t m_Lane;
+            std::size_t operator*() const { return m_Lane; }
+            Iterator& operator++() { ++m_Lane; return *this; }
+            bool operator!=(const Iterator& other) const { return m_Lane != other.m_Lane; }
+        };
+        Iterator begin() const { return Iterator{m_Begin}; }
+        Iterator end() const { return Iterator{m_End}; }
+
+        std::size_t m_Begin;
+        std::size_t m_End;
+    };
+
+    // Lanes of a divergent warp that fetched the same opcode.
+    struct LaneList {
+        const std::size_t* begin() const { return m_Lanes; }
+        const std::size_t* end() const { return m_Lanes + m_Count; }
+
+        std::size_t m_Lanes[CHIP8Batch::WARP_SIZE];
+        std::size_t m_Count;
+    };
+}
+
+CHIP8Batch::CHIP8Batch(std::size_t lanes, uint32_t seed)
+    : m_Lanes(lanes), m_Seed(seed) {
+    m_BootMemory.assign(CHIP8BootImage::POWER_ON_MEMORY.m_Bytes, CHIP8BootImage::POWER_ON_MEMORY.m_Bytes + MEMORY_SIZE);
+    m_Memory.resize(lanes * MEMORY_STRIDE);
+    for (auto& reg : m_Registers) {
+        reg.resize(lanes);
+    }
+    m_AddressI.resize(lanes);
+    m_ProgramCounter.resize(lanes);
+    m_Stack.resize(lanes * STACK_DEPTH);
+    m_StackPointer.resize(lanes);
+    m_DelayTimer.resize(lanes);
+    m_SoundTimer.resize(lanes);
+    m_Keypad.resize(lanes);
+    m_Screen.resize(lanes * SCREEN_ROWS);
+    m_RandomState.resize(lanes);
+    m_Opcode.resize(lanes);
+
+    reset();
+}
+
+void CHIP8Batch::loadROM(const BYTE* rom, std::size_t size) {
+    const std::size_t loadOffset = 0x200;
+    const std::size_t capacity = MEMORY_SIZE - loadOffset;
+
+    std::memcpy(m_BootMemory.data(), CHIP8BootImage::POWER_ON_MEMORY.m_Bytes, MEMORY_SIZE);
+    std::memcpy(&m_BootMemory[loadOffset], rom, std::min(size, capacity));
+    reset();
+}
+
+void CHIP8Batch::loadBootImage(const CHIP8BootImage& image) {
+    std::memcpy(m_BootMemory.data(), image.image().m_GameMemory, MEMORY_SIZE);
+    reset();
+}
+
+void CHIP8Batch::reset() {
+    for (std::size_t lane = 0; lane < m_Lanes; ++lane) {
+        resetLane(lane);
+    }
+}
+
+void CHIP8Batch::resetLane(std::size_t lane) {
+    std::memcpy(&m_Memory[lane * MEMORY_STRIDE], m_BootMemory.data(), MEMORY_SIZE);
+    for (auto& reg : m_Registers) {
+        reg[lane] = 0;
+    }
+    m_AddressI[lane] = 0;
+    m_ProgramCounter[lane] = 0x200;
+    m_StackPointer[lane] = 0;
+    m_DelayTimer[lane] = 0;
+    m_SoundTimer[lane] = 0;
+    m_Keypad[lane] = 0;
+    std::memset(&m_Screen[lane * SCREEN_ROWS], 0, SCREEN_ROWS * sizeof(uint64_t));
+
+    // xorshift must never be seeded with zero.
+    const uint32_t state = m_Seed ^ static_cast<uint32_t>(lane * 0x9E3779B9u);
+    m_RandomState[lane] = state ? state : 0x2545F491u;
+}
+
+void CHIP8Batch::copyLane(std::size_t lane, CHIP8Context& out) const {
+    static_assert(sizeof(out.m_GameMemory) == MEMORY_SIZE, "batch and scalar memory sizes differ");
+    static_assert(sizeof(out.m_Stack) / sizeof(out.m_Stack[0]) == STACK_DEPTH, "batch and scalar stack depths differ");
+
+    std::memcpy(out.m_GameMemory, &m_Memory[lane * MEMORY_STRIDE], MEMORY_SIZE);
+    for (int reg = 0; reg < 16; ++reg) {
+        out.m_Registers[reg] = m_Registers[reg][lane];
+    }
+    out.m_AddressI = m_AddressI[lane];
+    out.m_ProgramCounter = m_ProgramCounter[lane];
+    std::memset(out.m_Stack, 0, sizeof(out.m_Stack));
+    std::memcpy(out.m_Stack, &m_Stack[lane * STACK_DEPTH], m_StackPointer[lane] * sizeof(WORD));
+    out.m_StackPointer = m_StackPointer[lane];
+    out.m_Keypad = m_Keypad[lane];
+    out.m_DelayTimer = m_DelayTimer[lane];
+    out.m_SoundTimer = m_SoundTimer[lane];
+    out.m_RandomState = m_RandomState[lane];
+    out.m_BlockMapId = 0;
+
+    const uint64_t* screen = &m_Screen[lane * SCREEN_ROWS];
+    for (int y = 0; y < SCREEN_ROWS; ++y) {
+        for (int x = 0; x < 64; ++x) {
+            out.m_ScreenData[x][y] = (screen[y] >> (63 - x)) & 1;
+        }
+    }
+}
+
+void CHIP8Batch::step(const uint16_t* actions, uint64_t* observations) {
+    CHIP8_PROFILE_SCOPE("batch.step");
+    if (actions) {
+        std::memcpy(m_Keypad.data(), actions, m_Lanes * sizeof(uint16_t));
+    }
+
+    runCycles(INSTRUCTIONS_PER_FRAME);
+
+    if (observations) {
+        std::memcpy(observations, m_Screen.data(), m_Screen.size() * sizeof(uint64_t));
+    }
+}
+
+void CHIP8Batch::runCycles(int count) {
+    m_UniformWarps = 0;
+    m_DivergentWarps = 0;
+    m_GroupedLanes = 0;
+    m_SingleLanes = 0;
+
+    // Lanes never interact, so each warp runs all count cycles before the next one starts and its state
+    // stays in cache throughout.
+    for (std::size_t begin = 0; begin < m_Lanes; begin += WARP_SIZE) {
+        const std::size_t end = std::min(begin + static_cast<std::size_t>(WARP_SIZE), m_Lanes);
+
+        for (int cycle = 0; cycle < count; ++cycle) {
+            fetch(begin, end);
+
+            const WORD first = m_Opcode[begin];
+            bool uniform = true;
+            for (std::size_t lane = begin + 1; lane < end; ++lane) {
+                uniform &= (m_Opcode[lane] == first);
+            }
+
+            bool scattered = false;
+            if (uniform) {
+                ++m_UniformWarps;
+                executeUniform(first, LaneRange{begin, end});
+            } else {
+                ++m_DivergentWarps;
+                scattered = executeDivergent(begin, end) * 2 < end - begin;
+            }
+            tickTimers(begin, end);
+
+            // Interleaving lanes at different PCs defeats the host's branch prediction, so once most of
+            // the warp has scattered, each lane runs the rest of the call on its own like a CHIP8Context.
+            if (scattered) {
+                for (std::size_t lane = begin; lane < end; ++lane) {
+                    runLane(lane, count - cycle - 1);
+                }
+                break;
+            }
+        }
+    }
+}
+
+void CHIP8Batch::runLane(std::size_t lane, int count) {
+    for (int cycle = 0; cycle < count; ++cycle) {
+        fetch(lane, lane + 1);
+        executeLane(m_Opcode[lane], lane);
+        tickTimers(lane, lane + 1);
+    }
+    m_SingleLanes += static_cast<uint64_t>(count);
+}
+
+void CHIP8Batch::fetch(std::size_t begin, std::size_t end) {
+    for (std::size_t lane = begin; lane < end; ++lane) {
+        const BYTE* memory = &m_Memory[lane * MEMORY_STRIDE];
+        const WORD pc = m_ProgramCounter[lane] & 0x0FFF;
+        m_Opcode[lane] = static_cast<WORD>((memory[pc] << 8) | memory[(pc + 1) & 0x0FFF]);
+        m_ProgramCounter[lane] = static_cast<WORD>(pc + 2);
+    }
+}
+
+/**
+ * Executes one cycle of a warp whose lanes fetched different opcodes. Lanes that share an opcode with
+ * at least MIN_GROUP_SIZE - 1 others still run it together, decoded once; the loop goes through a lane
+ * list, so it no longer vectorizes, but the decode and dispatch are shared. Groups are looked for
+ * starting from the lowest lane left, and once that lane finds too few partners the remaining lanes run
+ * one by one, so a fully divergent warp pays for a single search.
+ * @return The number of lanes that ran in a group.
+ */
+std::size_t CHIP8Batch::executeDivergent(std::size_t begin, std::size_t end) {
+    const std::size_t width = end - begin;
+    const WORD* opcodes = &m_Opcode[begin];
+    uint32_t pending = width == 32 ? 0xFFFFFFFFu : (1u << width) - 1;
+    std::size_t grouped = 0;
+
+    while (pending) {
+        const std::size_t first = static_cast<std::size_t>(__builtin_ctz(pending));
+        const WORD opcode = opcodes[first];
+        uint32_t matching = 0;
+        for (std::size_t i = 0; i < width; ++i) {
+            matching |= static_cast<uint32_t>(opcodes[i] == opcode) << i;
+        }
+        matching &= pending;
+
+        if (__builtin_popcount(matching) < MIN_GROUP_SIZE) {
+            for (std::size_t i = first; i < width; ++i) {
+                if ((pending >> i) & 1) {
+                    executeLane(opcodes[i], begin + i);
+                }
+            }
+            m_SingleLanes += static_cast<uint64_t>(__builtin_popcount(pending));
+            break;
+        }
+
+        LaneList group;
+        group.m_Count = 0;
+        for (uint32_t bits = matching; bits; bits &= bits - 1) {
+            group.m_Lanes[group.m_Count++] = begin + static_cast<std::size_t>(__builtin_ctz(bits));
+        }
+        executeUniform(opcode, group);
+        grouped += group.m_Count;
+        pending &= ~matching;
+    }
+    m_GroupedLanes += grouped;
+    return grouped;
+}
+
+void CHIP8Batch::tickTimers(std::size_t begin, std::size_t end) {
+    // Mirrors the SDL frontend, which ticks both timers after every instruction.
+    BYTE* delay = m_DelayTimer.data();
+    BYTE* sound = m_SoundTimer.data();
+    for (std::size_t lane = begin; lane < end; ++lane) {
+        delay[lane] = static_cast<BYTE>(delay[lane] - (delay[lane] != 0));
+        sound[lane] = static_cast<BYTE>(sound[lane] - (sound[lane] != 0));
+    }
+}
+
+/**
+ * Executes one opcode shared by every lane in lanes, a LaneRange or a LaneList.
+ * The operands are decoded once and the body is a branch-free loop; over a LaneRange
+ * the arrays are contiguous so the compiler can vectorize it. Instructions whose work
+ * depends on per-lane memory fall back to executeLane.
+ */
+template <typename Lanes>
+void CHIP8Batch::executeUniform(WORD opcode, const Lanes& lanes) {
+    const int x = (opcode & 0x0F00) >> 8;
+    const int y = (opcode & 0x00F0) >> 4;
+    const BYTE NN = opcode & 0x00FF;
+    const WORD NNN = opcode & 0x0FFF;
+
+    BYTE* vx = m_Registers[x].data();
+    const BYTE* vy = m_Registers[y].data();
+    BYTE* vf = m_Registers[0xF].data();
+    WORD* pc = m_ProgramCounter.data();
+
+    switch (opcode & 0xF000) {
+        case 0x1000:
+            for (std::size_t l : lanes) pc[l] = NNN;
+            return;
+
+        case 0x3000:
+            for (std::size_t l : lanes) pc[l] += (vx[l] == NN) ? 2 : 0;
+            return;
+
+        case 0x4000:
+            for (std::size_t l : lanes) pc[l] += (vx[l] != NN) ? 2 : 0;
+            return;
+
+        case 0x5000:
+            for (std::size_t l : lanes) pc[l] += (vx[l] == vy[l]) ? 2 : 0;
+            return;
+
+        case 0x6000:
+            for (std::size_t l : lanes) vx[l] = NN;
+            return;
+
+        case 0x7000:
+            for (std::size_t l : lanes) vx[l] = static_cast<BYTE>(vx[l] + NN);
+            return;
+
+        case 0x8000:
+            // VF is written before VX is recomputed, like the reference, which matters when X or Y is F.
+            switch (opcode & 0x000F) {
+                case 0x0000:
+                    for (std::size_t l : lanes) vx[l] = vy[l];
+                    return;
+                case 0x0001:
+                    for (std::size_t l : lanes) vx[l] |= vy[l];
+                    return;
+                case 0x0002:
+                    for (std::size_t l : lanes) vx[l] &= vy[l];
+                    return;
+                case 0x0003:
+                    for (std::size_t l : lanes) vx[l] ^= vy[l];
+                    return;
+                case 0x0004:
+                    for (std::size_t l : lanes) {
+                        const unsigned sum = static_cast<unsigned>(vx[l]) + vy[l];
+                        vf[l] = (sum > 0xFF) ? 1 : 0;
+                        vx[l] = static_cast<BYTE>(sum);
+                    }
+                    return;
+                case 0x0005:
+                    for (std::size_t l : lanes) {
+                        vf[l] = (vx[l] >= vy[l]) ? 1 : 0;
+                        vx[l] = static_cast<BYTE>(vx[l] - vy[l]);
+                    }
+                    return;
+                case 0x0006:
+                    for (std::size_t l : lanes) {
+                        vf[l] = vx[l] & 1;
+                        vx[l] = static_cast<BYTE>(vx[l] >> 1);
+                    }
+                    return;
+                case 0x0007:
+                    for (std::size_t l : lanes) {
+                        vf[l] = (vy[l] >= vx[l]) ? 1 : 0;
+                        vx[l] = static_cast<BYTE>(vy[l] - vx[l]);
+                    }
+                    return;
+                case 0x000E:
+                    for (std::size_t l : lanes) {
+                        vf[l] = (vx[l] >> 7) & 1;
+                        vx[l] = static_cast<BYTE>(vx[l] << 1);
+                    }
+                    return;
+                default: // Undefined instruction, ignored like the reference interpreter.
+                    return;
+            }
+
+        case 0x9000:
+            for (std::size_t l : lanes) pc[l] += (vx[l] != vy[l]) ? 2 : 0;
+            return;
+
+        case 0xA000:
+            for (std::size_t l : lanes) m_AddressI[l] = NNN;
+            return;
+
+        case 0xB000:
+            for (std::size_t l : lanes) pc[l] = static_cast<WORD>(NNN + m_Registers[0][l]);
+            return;
+
+        default:
+            for (std::size_t l : lanes) {
+                executeLane(opcode, l);
+            }
+            return;
+    }
+}
+
+/**
+ * Executes one opcode on a single lane. Semantics follow CHIP8Context::execute, except that
+ * memory accesses wrap at 4 KB and the call stack holds STACK_DEPTH entries.
+ */
+void CHIP8Batch::executeLane(WORD opcode, std::size_t lane) {
+    const int x = (opcode & 0x0F00) >> 8;
+    const int y = (opcode & 0x00F0) >> 4;
+    const BYTE NN = opcode & 0x00FF;
+    const WORD NNN = opcode & 0x0FFF;
+
+    BYTE* memory = &m_Memory[lane * MEMORY_STRIDE];
+    BYTE& Vx = m_Registers[x][lane];
+    BYTE& Vy = m_Registers[y][lane];
+    BYTE& VF = m_Registers[0xF][lane];
+    WORD& pc = m_ProgramCounter[lane];
+    WORD& I = m_AddressI[lane];
+    WORD* stack = &m_Stack[lane * STACK_DEPTH];
+    BYTE& sp = m_StackPointer[lane];
+    uint64_t* screen = &m_Screen[lane * SCREEN_ROWS];
+
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            if (opcode == 0x00E0) {
+                std::memset(screen, 0, SCREEN_ROWS * sizeof(uint64_t));
+            } else if (opcode == 0x00EE) {
+                if (sp > 0) {
+                    pc = stack[--sp];
+                } else {
+                    pc = 0x200; // stack underflow, same recovery as the reference interpreter
+                }
+            }
+            break;
+
+        case 0x1000:
+            pc = NNN;
+            break;
+
+        case 0x2000:
+            if (sp < STACK_DEPTH) {
+                stack[sp++] = pc; // deeper calls are dropped, like the reference interpreter
+            }
+            pc = NNN;
+            break;
+
+        case 0x3000:
+            if (Vx == NN) pc += 2;
+            break;
+
+        case 0x4000:
+            if (Vx != NN) pc += 2;
+            break;
+
+        case 0x5000:
+            if (Vx == Vy) pc += 2;
+            break;
+
+        case 0x6000:
+            Vx = NN;
+            break;
+
+        case 0x7000:
+            Vx = static_cast<BYTE>(Vx + NN);
+            break;
+
+        case 0x8000:
+            switch (opcode & 0x000F) {
+                case 0x0000: Vx = Vy; break;
+                case 0x0001: Vx |= Vy; break;
+                case 0x0002: Vx &= Vy; break;
+                case 0x0003: Vx ^= Vy; break;
+                case 0x0004: {
+                    const unsigned sum = static_cast<unsigned>(Vx) + Vy;
+                    VF = (sum > 0xFF) ? 1 : 0;
+                    Vx = static_cast<BYTE>(sum);
+                    break;
+                }
+                case 0x0005:
+                    VF = (Vx >= Vy) ? 1 : 0;
+                    Vx = static_cast<BYTE>(Vx - Vy);
+                    break;
+                case 0x0006:
+                    VF = Vx & 1;
+                    Vx = static_cast<BYTE>(Vx >> 1);
+                    break;
+                case 0x0007:
+                    VF = (Vy >= Vx) ? 1 : 0;
+                    Vx = static_cast<BYTE>(Vy - Vx);
+                    break;
+                case 0x000E:
+                    VF = (Vx >> 7) & 1;
+                    Vx = static_cast<BYTE>(Vx << 1);
+                    break;
+                default: // Undefined instruction.
+                    break;
+            }
+            break;
+
+        case 0x9000:
+            if (Vx != Vy) pc += 2;
+            break;
+
+        case 0xA000:
+            I = NNN;
+            break;
+
+        case 0xB000:
+            pc = static_cast<WORD>(NNN + m_Registers[0][lane]);
+            break;
+
+        case 0xC000:
+            Vx = static_cast<BYTE>(nextRandom(m_RandomState[lane]) & NN);
+            break;
+
+        case 0xD000: {
+            const int height = opcode & 0x000F;
+            const int shift = Vx & 63;
+            const int top = Vy;
+            BYTE collision = 0;
+
+            for (int row = 0; row < height; ++row) {
+                const uint64_t sprite = static_cast<uint64_t>(memory[(I + row) & 0x0FFF]) << 56;
+                // Rotate so pixels that run off the right edge wrap to the left, like the reference.
+                const uint64_t bits = shift ? (sprite >> shift) | (sprite << (64 - shift)) : sprite;
+                uint64_t& line = screen[(top + row) & 31];
+                collision |= (line & bits) != 0;
+                line ^= bits;
+            }
+            VF = collision;
+            break;
+        }
+
+        case 0xE000: {
+            const bool pressed = (m_Keypad[lane] >> (Vx & 0x0F)) & 1;
+            // Decoded on the low nibble only, exactly like CHIP8Context::execute.
+            if ((opcode & 0x000F) == 0x000E && pressed) pc += 2;
+            if ((opcode & 0x000F) == 0x0001 && !pressed) pc += 2;
+            break;
+        }
+
+        case 0xF000:
+            // Decoded the same way as CHIP8Context::execute: FX2?, FX3?, FX5? and FX6? ignore the low nibble.
+            switch (opcode & 0x00F0) {
+                case 0x0020: opcode = 0xF029; break;
+                case 0x0030: opcode = 0xF033; break;
+                case 0x0050: opcode = 0xF055; break;
+                case 0x0060: opcode = 0xF065; break;
+                default: break;
+            }
+            switch (opcode & 0x00FF) {
+                case 0x0007:
+                    Vx = m_DelayTimer[lane];
+                    break;
+                case 0x000A: {
+                    const uint16_t keys = m_Keypad[lane];
+                    if (keys) {
+                        BYTE key = 0;
+                        while (!((keys >> key) & 1)) ++key; // lowest pressed key wins
+                        Vx = key;
+                    } else {
+                        pc -= 2; // re-execute until a key is pressed
+                    }
+                    break;
+                }
+                case 0x0015:
+                    m_DelayTimer[lane] = Vx;
+                    break;
+                case 0x0018:
+                    m_SoundTimer[lane] = Vx;
+                    break;
+                case 0x001E:
+                    I = static_cast<WORD>(I + Vx);
+                    break;
+                case 0x0029:
+                    I = static_cast<WORD>(CHIP8BootImage::FONT_BASE + (Vx & 0x0F) * CHIP8BootImage::GLYPH_SIZE);
+                    break;
+                case 0x0033:
+                    memory[I & 0x0FFF] = Vx / 100;
+                    memory[(I + 1) & 0x0FFF] = (Vx / 10) % 10;
+                    memory[(I + 2) & 0x0FFF] = Vx % 10;
+                    break;
+                case 0x0055:
+                    for (int i = 0; i <= x; ++i) {
+                        memory[(I + i) & 0x0FFF] = m_Registers[i][lane];
+                    }
+                    break;
+                case 0x0065:
+                    for (int i = 0; i <= x; ++i) {
+                        m_Registers[i][lane] = memory[(I + i) & 0x0FFF];
+                    }
+                    break;
+                default: // Undefined instruction.
+                    break;
+            }
+            break;
+    }
+}
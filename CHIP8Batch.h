@@ -0,0 +1,119 @@
+//
+// Batched CHIP-8 interpreter: N machines stored as structure-of-arrays and run in lockstep.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_CHIP8BATCH_H
+#define MY_CHIP_8_EMULATOR_CHIP8BATCH_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct CHIP8Context;
+class CHIP8BootImage;
+
+struct CHIP8Batch {
+    using BYTE = uint8_t;
+    using WORD = uint16_t;
+
+    static constexpr int MEMORY_SIZE = 0x1000;
+    // Lanes' memories are a cache line more than 4K apart. At exactly 4K, the same address in every lane
+    // of a warp maps to the same L1 set, and a warp fetching one PC evicts itself.
+    static constexpr int MEMORY_STRIDE = MEMORY_SIZE + 64;
+    static constexpr int STACK_DEPTH = 16;
+    static constexpr int SCREEN_ROWS = 32; // one 64-bit word per row, bit 63 is x = 0
+    static constexpr int INSTRUCTIONS_PER_FRAME = 15; // 900 instructions per second at 60Hz
+    static constexpr int WARP_SIZE = 32; // lanes checked together for a shared opcode
+    static constexpr int MIN_GROUP_SIZE = 4; // lanes of a divergent warp worth running together
+
+    /**
+     * Creates a batch of machines.
+     * @param lanes The number of machines to run in lockstep.
+     * @param seed Seed for the per-lane random number generators used by CXNN.
+     */
+    explicit CHIP8Batch(std::size_t lanes, uint32_t seed = 0x2545F491u);
+
+    /**
+     * Sets the image every lane boots from: the font plus the ROM. Bytes past the end of memory are ignored.
+     * @param rom The ROM contents, loaded at 0x200.
+     * @param size The size of the ROM in bytes.
+     * @post All lanes are reset to the new image.
+     */
+    void loadROM(const BYTE* rom, std::size_t size);
+
+    /**
+     * Sets the image every lane boots from to the memory of an already loaded boot image.
+     * @param image The image, including its font and ROM.
+     * @post All lanes are reset to the new image.
+     */
+    void loadBootImage(const CHIP8BootImage& image);
+
+    /**
+     * @post Every lane is reset to the boot image.
+     */
+    void reset();
+
+    /**
+     * @param lane The lane to reset.
+     * @post The given lane is reset to the boot image. Other lanes are untouched.
+     */
+    void resetLane(std::size_t lane);
+
+    /**
+     * Runs every lane for one 60Hz frame.
+     * @param actions One keypad bitmask per lane (bit N set means key N is held). May be null to keep the current keys.
+     * @param observations Receives SCREEN_ROWS words per lane, lane-major. May be null.
+     */
+    void step(const uint16_t* actions, uint64_t* observations);
+
+    /**
+     * Runs every lane for a number of instructions, ticking the timers after each one like the SDL frontend does.
+     * @param count The number of instructions to run.
+     */
+    void runCycles(int count);
+
+    /**
+     * Converts one lane to the scalar representation, e.g. to compare it against the reference interpreter.
+     * @param lane The lane to copy.
+     * @param out Receives the lane's complete state.
+     */
+    void copyLane(std::size_t lane, CHIP8Context& out) const;
+
+    std::size_t lanes() const { return m_Lanes; }
+
+    // Statistics for the most recent calls to runCycles / step.
+    uint64_t m_UniformWarps = 0;   // warp cycles executed with a single shared opcode
+    uint64_t m_DivergentWarps = 0; // warp cycles whose lanes fetched more than one opcode
+    uint64_t m_GroupedLanes = 0;   // lane instructions of divergent warps that still ran together with others
+    uint64_t m_SingleLanes = 0;    // lane instructions run one lane at a time
+
+    // Per-lane state, structure-of-arrays. Register r of lane l lives at m_Registers[r][l].
+    std::size_t m_Lanes;
+    std::vector<BYTE> m_BootMemory;     // MEMORY_SIZE bytes every lane resets to
+    std::vector<BYTE> m_Memory;         // MEMORY_SIZE bytes per lane, MEMORY_STRIDE apart
+    std::vector<BYTE> m_Registers[16];
+    std::vector<WORD> m_AddressI;
+    std::vector<WORD> m_ProgramCounter;
+    std::vector<WORD> m_Stack;          // STACK_DEPTH entries per lane, lane-major
+    std::vector<BYTE> m_StackPointer;
+    std::vector<BYTE> m_DelayTimer;
+    std::vector<BYTE> m_SoundTimer;
+    std::vector<uint16_t> m_Keypad;     // bitmask, bit N set means key N is held
+    std::vector<uint64_t> m_Screen;     // SCREEN_ROWS words per lane, lane-major
+    std::vector<uint32_t> m_RandomState;
+
+private:
+    uint32_t m_Seed;
+    std::vector<WORD> m_Opcode; // scratch: the opcode fetched by each lane this cycle
+
+    void fetch(std::size_t begin, std::size_t end);
+    void runLane(std::size_t lane, int count);
+    std::size_t executeDivergent(std::size_t begin, std::size_t end);
+    template <typename Lanes>
+    void executeUniform(WORD opcode, const Lanes& lanes);
+    void executeLane(WORD opcode, std::size_t lane);
+    void tickTimers(std::size_t begin, std::size_t end);
+};
+
+
+#endif //MY_CHIP_8_EMULATOR_CHIP8BATCH_H
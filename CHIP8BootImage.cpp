@@ -0,0 +1,145 @@
+//
+// Boot images. See CHIP8BootImage.h.
+//
+#include "CHIP8BootImage.h"
+#include "CHIP8Analyzer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CHIP8_HAS_MMAP 1
+#endif
+
+constexpr uint16_t CHIP8BootImage::FONT_BASE;
+constexpr uint16_t CHIP8BootImage::GLYPH_SIZE;
+constexpr uint16_t CHIP8BootImage::ROM_BASE;
+constexpr size_t CHIP8BootImage::ROM_CAPACITY;
+
+namespace {
+    // Each glyph is 4 pixels wide and 5 rows tall. Rows are packed one nibble each, top row first,
+    // so 0xF999F is the digit 0.
+    constexpr uint32_t GLYPH_ROWS[16] = {
+        0xF999F, 0x26227, 0xF1F8F, 0xF1F1F, 0x99F11, 0xF8F1F, 0xF8F9F, 0xF1244,
+        0xF9F9F, 0xF9F1F, 0xF9F99, 0xE9E9E, 0xF888F, 0xE999E, 0xF8F8F, 0xF8F88
+    };
+
+    constexpr CHIP8BootImage::Memory makePowerOnMemory() {
+        CHIP8BootImage::Memory memory{};
+        for (int digit = 0; digit < 16; ++digit) {
+            for (int row = 0; row < CHIP8BootImage::GLYPH_SIZE; ++row) {
+                // Glyph pixels occupy the high nibble of each sprite byte.
+                const uint32_t nibble = (GLYPH_ROWS[digit] >> (4 * (CHIP8BootImage::GLYPH_SIZE - 1 - row))) & 0xF;
+                memory.m_Bytes[CHIP8BootImage::FONT_BASE + digit * CHIP8BootImage::GLYPH_SIZE + row] =
+                    static_cast<uint8_t>(nibble << 4);
+            }
+        }
+        return memory;
+    }
+
+    // A ROM file must hold at least one instruction byte and fit between ROM_BASE and the end of memory.
+    bool checkSize(const char* path, size_t size) {
+        if (size == 0) {
+            std::fprintf(stderr, "ROM is empty: %s\n", path);
+            return false;
+        }
+        if (size > CHIP8BootImage::ROM_CAPACITY) {
+            std::fprintf(stderr, "ROM is too large: %s does not fit in the %zu bytes from 0x200\n",
+                         path, CHIP8BootImage::ROM_CAPACITY);
+            return false;
+        }
+        return true;
+    }
+}
+
+// Constant-initialized, so it is ready before any other static constructor can reset a machine.
+const CHIP8BootImage::Memory CHIP8BootImage::POWER_ON_MEMORY = makePowerOnMemory();
+
+CHIP8BootImage::CHIP8BootImage() {
+    m_Image.resetState();
+    m_Image.seedRandom(0);
+}
+
+size_t CHIP8BootImage::loadROM(const uint8_t* rom, size_t size) {
+    m_Image.resetState();
+    m_Image.seedRandom(0);
+    m_RomSize = size > 0 ? m_Image.loadROM(rom, size) : 0;
+    m_BlockMap.reset();
+    return m_RomSize;
+}
+
+void CHIP8BootImage::predecode() {
+    // A fresh map rather than an update: copies of the image may still share the old one.
+    auto map = std::make_shared<CHIP8BlockMap>();
+    buildBlockMap(analyzeMemory(m_Image.m_GameMemory, m_RomSize), *map);
+    m_Image.m_BlockMapId = map->m_Id;
+    m_BlockMap = std::move(map);
+}
+
+bool CHIP8BootImage::loadFile(const char* path) {
+#ifdef CHIP8_HAS_MMAP
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open ROM");
+        loadROM(nullptr, 0);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        perror("Failed to stat ROM");
+        ::close(fd);
+        loadROM(nullptr, 0);
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (!checkSize(path, size)) {
+        ::close(fd);
+        loadROM(nullptr, 0);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("Failed to map ROM");
+        loadROM(nullptr, 0);
+        return false;
+    }
+
+    loadROM(static_cast<const uint8_t*>(mapped), size);
+    munmap(mapped, size);
+    return true;
+#else
+    FILE* in = std::fopen(path, "rb");
+    if (!in) {
+        perror("Failed to open ROM");
+        loadROM(nullptr, 0);
+        return false;
+    }
+
+    // One byte of headroom, so a ROM that does not fit reads as too large rather than as truncated.
+    uint8_t rom[ROM_CAPACITY + 1];
+    const size_t bytesRead = std::fread(rom, 1, sizeof(rom), in);
+    const bool failed = std::ferror(in) != 0;
+    std::fclose(in);
+    if (failed) {
+        perror("Failed to read ROM");
+        loadROM(nullptr, 0);
+        return false;
+    }
+    if (!checkSize(path, bytesRead)) {
+        loadROM(nullptr, 0);
+        return false;
+    }
+
+    loadROM(rom, bytesRead);
+    return true;
+#endif
+}
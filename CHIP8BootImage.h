@@ -0,0 +1,92 @@
+//
+// Boot images: the exact machine state a ROM starts from, built once so that a reset is a single copy.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_CHIP8BOOTIMAGE_H
+#define MY_CHIP_8_EMULATOR_CHIP8BOOTIMAGE_H
+
+#include "CHIP8.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * A ROM loaded into a freshly powered-on machine: reset registers, the hexadecimal font at FONT_BASE and
+ * the ROM at 0x200. The image is immutable once loaded; booting a machine copies it and sets the seed.
+ */
+class CHIP8BootImage {
+public:
+    static constexpr uint16_t FONT_BASE = 0x050;  // where FX29 expects the digit glyphs
+    static constexpr uint16_t GLYPH_SIZE = 5;     // bytes per glyph
+    static constexpr uint16_t ROM_BASE = 0x200;
+    static constexpr size_t ROM_CAPACITY = 0x1000 - ROM_BASE;
+
+    /**
+     * Memory of a machine with no ROM: zero apart from the font. Generated at compile time.
+     */
+    struct Memory {
+        uint8_t m_Bytes[0x1000];
+    };
+    static const Memory POWER_ON_MEMORY;
+
+    /**
+     * @post The image holds a machine with the font loaded and no ROM.
+     */
+    CHIP8BootImage();
+
+    /**
+     * Builds the image from a ROM in memory.
+     * @param rom The ROM contents.
+     * @param size The size of the ROM in bytes.
+     * @return The number of bytes loaded. ROMs larger than ROM_CAPACITY are truncated.
+     */
+    size_t loadROM(const uint8_t* rom, size_t size);
+
+    /**
+     * Builds the image from a ROM file. The file is mapped rather than read where the platform allows.
+     * @param path The ROM file.
+     * @return false if the file could not be opened or read, is empty, or is larger than ROM_CAPACITY.
+     *         The image is left empty in that case.
+     */
+    bool loadFile(const char* path);
+
+    /**
+     * Analyzes the ROM and attaches a CHIP8BlockMap of its reachable code. Machines booted from the
+     * image afterwards can run it with CHIP8Context::runCyclesPredecoded(*blockMap(), ...), which skips
+     * fetching and decoding those instructions. Copies of the image share the map, which is freed with
+     * the last of them; machines only carry its id, so they never keep it alive or point at a freed map.
+     * Loading another ROM detaches it.
+     *
+     * Off by default (--predecode in the frontend and chip8-difftest): the interpreter's own decode
+     * compiles to a jump table and is already about as fast.
+     */
+    void predecode();
+
+    /**
+     * @return The map attached by predecode(), or null.
+     */
+    const CHIP8BlockMap* blockMap() const { return m_BlockMap.get(); }
+
+    /**
+     * Resets a machine to this image.
+     * @param chip8 The machine to reset.
+     * @param seed Seed for CXNN.
+     * @post chip8 is an exact copy of the image apart from the random state.
+     */
+    void boot(CHIP8Context& chip8, uint32_t seed) const {
+        chip8 = m_Image;
+        chip8.seedRandom(seed);
+    }
+
+    const CHIP8Context& image() const { return m_Image; }
+    size_t romSize() const { return m_RomSize; }
+
+private:
+    CHIP8Context m_Image;
+    size_t m_RomSize = 0;
+    std::shared_ptr<const CHIP8BlockMap> m_BlockMap;
+};
+
+
+#endif //MY_CHIP_8_EMULATOR_CHIP8BOOTIMAGE_H
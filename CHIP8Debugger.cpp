@@ -0,0 +1,111 @@
+//
+// Debugger core. See CHIP8Debugger.h.
+//
+#include "CHIP8Debugger.h"
+
+#include <cstring>
+
+constexpr uint8_t CHIP8Debugger::BREAKPOINT;
+constexpr uint8_t CHIP8Debugger::WATCH_READ;
+constexpr uint8_t CHIP8Debugger::WATCH_WRITE;
+
+CHIP8Debugger::CHIP8Debugger() {
+    clear();
+}
+
+void CHIP8Debugger::setBreakpoint(uint16_t address, bool enabled) {
+    uint8_t& flags = m_Flags[address & 0x0FFF];
+    flags = static_cast<uint8_t>(enabled ? (flags | BREAKPOINT) : (flags & ~BREAKPOINT));
+}
+
+void CHIP8Debugger::setWatchpoint(uint16_t address, size_t length, uint8_t kinds, bool enabled) {
+    kinds &= WATCH_READ | WATCH_WRITE;
+    for (size_t i = 0; i < length && i < 0x1000; ++i) {
+        uint8_t& flags = m_Flags[(address + i) & 0x0FFF];
+        const bool watchedBefore = (flags & (WATCH_READ | WATCH_WRITE)) != 0;
+        flags = static_cast<uint8_t>(enabled ? (flags | kinds) : (flags & ~kinds));
+        const bool watchedAfter = (flags & (WATCH_READ | WATCH_WRITE)) != 0;
+        if (watchedAfter != watchedBefore) {
+            m_Watched = watchedAfter ? m_Watched + 1 : m_Watched - 1;
+        }
+    }
+}
+
+void CHIP8Debugger::clear() {
+    std::memset(m_Flags, 0, sizeof(m_Flags));
+    m_Watched = 0;
+}
+
+CHIP8StopInfo CHIP8Debugger::run(CHIP8Context& chip8, int count) {
+    // A client may have moved PC since the stop; then the new instruction is checked like any other.
+    const bool resuming = m_StoppedAt == (chip8.m_ProgramCounter & 0x0FFF);
+    m_StoppedAt = -1;
+    chip8.m_BlockMapId = 0; // runs through execute(), which does not track writes over code
+
+    for (int i = 0; i < count; ++i) {
+        if (i > 0 || !resuming) {
+            const uint16_t pc = chip8.m_ProgramCounter & 0x0FFF;
+            if (m_Flags[pc] & BREAKPOINT) {
+                m_StoppedAt = pc;
+                return CHIP8StopInfo{CHIP8StopReason::BREAKPOINT, pc, i};
+            }
+
+            uint16_t address;
+            size_t length;
+            const uint8_t kind = m_Watched ? memoryAccess(chip8, address, length) : 0;
+            for (size_t j = 0; kind && j < length; ++j) {
+                const uint16_t byte = (address + j) & 0x0FFF;
+                if (m_Flags[byte] & kind) {
+                    m_StoppedAt = pc;
+                    return CHIP8StopInfo{kind == WATCH_READ ? CHIP8StopReason::WATCH_READ : CHIP8StopReason::WATCH_WRITE,
+                                         byte, i};
+                }
+            }
+        }
+
+        chip8.execute();
+        chip8.tickTimers();
+    }
+    return CHIP8StopInfo{CHIP8StopReason::NONE, static_cast<uint16_t>(chip8.m_ProgramCounter & 0x0FFF), count};
+}
+
+CHIP8StopInfo CHIP8Debugger::step(CHIP8Context& chip8) {
+    m_StoppedAt = -1;
+    chip8.m_BlockMapId = 0;
+    chip8.execute();
+    chip8.tickTimers();
+    return CHIP8StopInfo{CHIP8StopReason::STEP, static_cast<uint16_t>(chip8.m_ProgramCounter & 0x0FFF), 1};
+}
+
+uint8_t CHIP8Debugger::memoryAccess(const CHIP8Context& chip8, uint16_t& address, size_t& length) {
+    const uint16_t pc = chip8.m_ProgramCounter & 0x0FFF;
+    const uint16_t opcode = static_cast<uint16_t>((chip8.m_GameMemory[pc] << 8) | chip8.m_GameMemory[(pc + 1) & 0x0FFF]);
+    const int x = (opcode & 0x0F00) >> 8;
+
+    address = chip8.m_AddressI & 0x0FFF;
+    switch (decodeOpcode(opcode)) {
+        case CHIP8Op::OP_DXYN:
+            length = opcode & 0x000F;
+            return WATCH_READ;
+        case CHIP8Op::OP_FX33:
+            length = 3;
+            return WATCH_WRITE;
+        case CHIP8Op::OP_FX55:
+            length = static_cast<size_t>(x) + 1;
+            return WATCH_WRITE;
+        case CHIP8Op::OP_FX65:
+            length = static_cast<size_t>(x) + 1;
+            return WATCH_READ;
+        default:
+            length = 0;
+            return 0;
+    }
+}
+
+void CHIP8Debugger::writeMemory(CHIP8Context& chip8, uint16_t address, const uint8_t* data, size_t length) {
+    // The block map is keyed on the ROM as loaded; a patched byte may be code it has already decoded.
+    chip8.m_BlockMapId = 0;
+    for (size_t i = 0; i < length; ++i) {
+        chip8.m_GameMemory[(address + i) & 0x0FFF] = data[i];
+    }
+}
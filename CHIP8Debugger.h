@@ -0,0 +1,106 @@
+//
+// Debugger core: PC breakpoints, memory watchpoints and single-stepping, as a separate execution loop so
+// CHIP8Context::runCycles stays untouched when no debugger is attached.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_CHIP8DEBUGGER_H
+#define MY_CHIP_8_EMULATOR_CHIP8DEBUGGER_H
+
+#include "CHIP8.h"
+
+#include <cstddef>
+#include <cstdint>
+
+enum class CHIP8StopReason : uint8_t {
+    NONE,        // ran the full count
+    STEP,        // a single step finished
+    BREAKPOINT,  // PC reached a breakpoint
+    WATCH_READ,  // the next instruction reads a watched byte
+    WATCH_WRITE  // the next instruction writes a watched byte
+};
+
+struct CHIP8StopInfo {
+    CHIP8StopReason m_Reason;
+    uint16_t m_Address;   // the breakpoint, or the first watched byte the instruction accesses
+    int m_Executed;       // instructions run before stopping
+};
+
+/**
+ * Runs a machine under breakpoints and watchpoints. This is a swap-in for CHIP8Context::runCycles in
+ * the same way TraceRecorder is: only code that calls CHIP8Debugger::run pays for the checks.
+ *
+ * Every stop happens before the instruction that caused it, so the machine can be inspected with PC
+ * still pointing at that instruction. Watchpoints cover the memory operands of DXYN (sprite read),
+ * FX33 (BCD write), FX55 (register store) and FX65 (register load); instruction fetches are not watched.
+ */
+class CHIP8Debugger {
+public:
+    static constexpr uint8_t BREAKPOINT = 1;
+    static constexpr uint8_t WATCH_READ = 2;
+    static constexpr uint8_t WATCH_WRITE = 4;
+
+    CHIP8Debugger();
+
+    /**
+     * @param address The instruction address; masked to 12 bits.
+     * @param enabled Sets or clears the breakpoint.
+     */
+    void setBreakpoint(uint16_t address, bool enabled);
+
+    /**
+     * @param address The first watched byte; the range wraps at 4K like the interpreter's accesses.
+     * @param length The number of bytes.
+     * @param kinds WATCH_READ, WATCH_WRITE or both.
+     * @param enabled Sets or clears those kinds over the range.
+     */
+    void setWatchpoint(uint16_t address, size_t length, uint8_t kinds, bool enabled);
+
+    /**
+     * @post No breakpoints or watchpoints remain.
+     */
+    void clear();
+
+    /**
+     * @return BREAKPOINT, WATCH_READ and WATCH_WRITE as set for the address.
+     */
+    uint8_t flags(uint16_t address) const { return m_Flags[address & 0x0FFF]; }
+
+    /**
+     * Runs up to count instructions, ticking the timers after each like CHIP8Context::runCycles.
+     * Every instruction is checked, except that a run starting where the previous run stopped executes
+     * that instruction first, so calling run again after a stop resumes past it. A long continue can
+     * therefore be split into any number of runs without missing a stop.
+     * @param chip8 The machine to run.
+     * @param count The most instructions to run.
+     * @return Why and where it stopped; NONE if all count instructions ran.
+     */
+    CHIP8StopInfo run(CHIP8Context& chip8, int count);
+
+    /**
+     * Runs exactly one instruction and ticks the timers, ignoring breakpoints and watchpoints.
+     * @return A STEP stop at the new PC.
+     */
+    CHIP8StopInfo step(CHIP8Context& chip8);
+
+    /**
+     * The memory operand of the instruction at PC.
+     * @param chip8 The machine, with PC at the instruction.
+     * @param address Receives the first byte accessed.
+     * @param length Receives the number of bytes; 0 for instructions without a memory operand.
+     * @return WATCH_READ, WATCH_WRITE or 0.
+     */
+    static uint8_t memoryAccess(const CHIP8Context& chip8, uint16_t& address, size_t& length);
+
+    /**
+     * Writes memory on behalf of a debugger client, dropping any predecoded block map.
+     */
+    static void writeMemory(CHIP8Context& chip8, uint16_t address, const uint8_t* data, size_t length);
+
+private:
+    uint8_t m_Flags[0x1000]; // BREAKPOINT, WATCH_READ and WATCH_WRITE per address
+    size_t m_Watched = 0;    // addresses with any watch flag, so runs without watchpoints skip the decode
+    int m_StoppedAt = -1;    // PC of the last stop, until the machine is run or stepped again
+};
+
+
+#endif //MY_CHIP_8_EMULATOR_CHIP8DEBUGGER_H
@@ -0,0 +1,232 @@
+//
+// Parallel state-space search. See CHIP8Explorer.h.
+//
+#include "CHIP8Explorer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <thread>
+
+namespace {
+    const int ACTIONS = 17; // no key, then keys 0x0..0xF
+
+    uint16_t keysFor(int action) {
+        return action == 0 ? 0 : static_cast<uint16_t>(1u << (action - 1));
+    }
+
+    struct Node {
+        CHIP8Context m_State;
+        uint32_t m_Parent; // index into the previous depth's frontier
+        uint8_t m_Action;
+        int64_t m_Score;
+    };
+
+    // How each state of a depth was reached; kept for every depth so the winning inputs can be replayed.
+    struct Step {
+        uint32_t m_Parent;
+        uint8_t m_Action;
+    };
+}
+
+StateHashSet::StateHashSet(size_t capacity) {
+    size_t slots = 1024;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+    m_Slots.reset(static_cast<std::atomic<uint64_t>*>(std::calloc(slots, sizeof(std::atomic<uint64_t>))));
+    if (!m_Slots) {
+        throw std::bad_alloc();
+    }
+    m_Mask = slots - 1;
+    m_Limit = slots - slots / 8;
+}
+
+StateHashSet::Insert StateHashSet::insert(uint64_t hash) {
+    if (hash == 0) {
+        hash = 1;
+    }
+
+    // The low bits pick the slot; stateHash ends in an avalanche, so they are as good as any.
+    for (size_t index = hash & m_Mask;; index = (index + 1) & m_Mask) {
+        uint64_t current = m_Slots[index].load(std::memory_order_relaxed);
+        if (current == hash) {
+            return Insert::PRESENT;
+        }
+        if (current == 0) {
+            if (m_Count.load(std::memory_order_relaxed) >= m_Limit) {
+                return Insert::FULL;
+            }
+            if (m_Slots[index].compare_exchange_strong(current, hash, std::memory_order_relaxed)) {
+                m_Count.fetch_add(1, std::memory_order_relaxed);
+                return Insert::ADDED;
+            }
+            if (current == hash) {
+                return Insert::PRESENT; // another thread added the same state first
+            }
+        }
+    }
+}
+
+ExplorerResult CHIP8Explorer::run(const CHIP8Context& start, const Goal& goal, const Score& score,
+                                  const Progress& progress) {
+    const auto began = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    };
+
+    int threads = m_Config.m_Threads > 0 ? m_Config.m_Threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(threads, 1);
+
+    ExplorerResult result;
+    result.m_State = start;
+    if (goal(start)) {
+        result.m_Found = true;
+        return result;
+    }
+
+    // A quarter of the budget goes to the hash set: 8 bytes per state against ~6.4KB per frontier state.
+    size_t slots = 1024;
+    while (slots * 2 * sizeof(uint64_t) <= m_Config.m_MemoryLimit / 4) {
+        slots <<= 1;
+    }
+    StateHashSet seen(slots);
+    seen.insert(start.stateHash());
+
+    std::vector<Node> frontier(1);
+    frontier[0].m_State = start;
+    frontier[0].m_Parent = 0;
+    frontier[0].m_Action = 0;
+    frontier[0].m_Score = 0;
+    std::vector<std::vector<Step>> history;
+    size_t historyBytes = 0;
+
+    for (int depth = 1; depth <= m_Config.m_MaxDepth && !frontier.empty(); ++depth) {
+        const size_t used = seen.bytes() + historyBytes + frontier.size() * sizeof(Node);
+        const size_t available = m_Config.m_MemoryLimit > used ? m_Config.m_MemoryLimit - used : 0;
+        const size_t perThreadCap = available / (sizeof(Node) + sizeof(Step)) / threads;
+
+        std::vector<std::vector<Node>> successors(threads);
+        std::vector<uint64_t> expanded(threads);
+        std::atomic<size_t> nextParent{0};
+        std::atomic<bool> found{false};
+        std::atomic<bool> cut{false};
+        std::mutex foundMutex;
+        uint32_t foundParent = 0;
+        uint8_t foundAction = 0;
+
+        auto worker = [&](int thread) {
+            std::vector<Node>& out = successors[thread];
+            size_t parent;
+            while (!found.load(std::memory_order_relaxed) &&
+                   (parent = nextParent.fetch_add(1, std::memory_order_relaxed)) < frontier.size()) {
+                for (int action = 0; action < ACTIONS; ++action) {
+                    // Built in place; popped again if it turns out to be a duplicate.
+                    out.emplace_back();
+                    Node& child = out.back();
+                    child.m_State = frontier[parent].m_State;
+                    child.m_State.m_Keypad = keysFor(action);
+                    child.m_State.runCycles(m_Config.m_CyclesPerFrame);
+                    ++expanded[thread];
+
+                    const StateHashSet::Insert inserted = seen.insert(child.m_State.stateHash());
+                    if (inserted == StateHashSet::Insert::PRESENT) {
+                        out.pop_back();
+                        continue;
+                    }
+
+                    if (goal(child.m_State)) {
+                        std::lock_guard<std::mutex> lock(foundMutex);
+                        if (!found.load(std::memory_order_relaxed)) {
+                            found.store(true, std::memory_order_relaxed);
+                            foundParent = static_cast<uint32_t>(parent);
+                            foundAction = static_cast<uint8_t>(action);
+                            result.m_State = child.m_State;
+                        }
+                        out.pop_back();
+                        return;
+                    }
+
+                    if (inserted == StateHashSet::Insert::FULL || out.size() > perThreadCap) {
+                        // Out of room: the state is explored no further, and the search is no longer exhaustive.
+                        cut.store(true, std::memory_order_relaxed);
+                        out.pop_back();
+                        continue;
+                    }
+
+                    child.m_Parent = static_cast<uint32_t>(parent);
+                    child.m_Action = static_cast<uint8_t>(action);
+                    child.m_Score = score ? score(child.m_State) : 0;
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int thread = 1; thread < threads; ++thread) {
+            pool.emplace_back(worker, thread);
+        }
+        worker(0);
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+
+        for (uint64_t count : expanded) {
+            result.m_Expanded += count;
+        }
+        result.m_HitMemoryLimit = result.m_HitMemoryLimit || cut.load();
+
+        if (found.load()) {
+            // Walk the history back from the winning parent to the start state.
+            result.m_Found = true;
+            result.m_Depth = depth;
+            result.m_Inputs.push_back(keysFor(foundAction));
+            uint32_t index = foundParent;
+            for (int level = depth - 1; level >= 1; --level) {
+                const Step& step = history[level - 1][index];
+                result.m_Inputs.push_back(keysFor(step.m_Action));
+                index = step.m_Parent;
+            }
+            std::reverse(result.m_Inputs.begin(), result.m_Inputs.end());
+            break;
+        }
+
+        std::vector<Node> next;
+        size_t total = 0;
+        for (const std::vector<Node>& part : successors) {
+            total += part.size();
+        }
+        next.reserve(total);
+        for (std::vector<Node>& part : successors) {
+            std::move(part.begin(), part.end(), std::back_inserter(next));
+            std::vector<Node>().swap(part);
+        }
+
+        if (m_Config.m_BeamWidth > 0 && next.size() > m_Config.m_BeamWidth) {
+            std::nth_element(next.begin(), next.begin() + m_Config.m_BeamWidth, next.end(),
+                             [](const Node& a, const Node& b) { return a.m_Score > b.m_Score; });
+            next.resize(m_Config.m_BeamWidth);
+        }
+
+        std::vector<Step> steps(next.size());
+        for (size_t i = 0; i < next.size(); ++i) {
+            steps[i] = Step{next[i].m_Parent, next[i].m_Action};
+        }
+        historyBytes += steps.size() * sizeof(Step);
+        history.push_back(std::move(steps));
+
+        frontier.swap(next);
+        std::vector<Node>().swap(next);
+
+        result.m_Depth = depth;
+        const size_t bytes = seen.bytes() + historyBytes + frontier.size() * sizeof(Node);
+        result.m_PeakBytes = std::max(result.m_PeakBytes, bytes);
+        if (progress) {
+            progress(ExplorerProgress{depth, frontier.size(), result.m_Expanded, seen.size(), elapsed(), bytes});
+        }
+    }
+
+    result.m_Unique = seen.size();
+    result.m_Seconds = elapsed();
+    return result;
+}
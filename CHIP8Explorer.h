@@ -0,0 +1,109 @@
+//
+// Parallel state-space search over keypad inputs: breadth-first or beam search from a snapshot, one
+// branch per key at every frame boundary, with duplicate states pruned through a shared hash set.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_CHIP8EXPLORER_H
+#define MY_CHIP_8_EMULATOR_CHIP8EXPLORER_H
+
+#include "CHIP8.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * A fixed-capacity set of 64-bit hashes that any number of threads can insert into without locks.
+ * Open addressing with linear probing; a slot is claimed with a single compare-and-swap.
+ */
+class StateHashSet {
+public:
+    enum class Insert { ADDED, PRESENT, FULL };
+
+    /**
+     * @param capacity The number of slots, rounded up to a power of two. The set reports FULL at 7/8 load.
+     */
+    explicit StateHashSet(size_t capacity);
+
+    /**
+     * @param hash The hash to add. Zero marks an empty slot, so it is stored as a different value.
+     * @return ADDED if the hash was new, PRESENT if it was already there, FULL if there was no room.
+     */
+    Insert insert(uint64_t hash);
+
+    size_t size() const { return m_Count.load(std::memory_order_relaxed); }
+    size_t capacity() const { return m_Mask + 1; }
+    size_t bytes() const { return capacity() * sizeof(uint64_t); }
+
+private:
+    // calloc'd so that untouched slots cost no more than zero pages the OS hands out lazily
+    std::unique_ptr<std::atomic<uint64_t>[], void (*)(void*)> m_Slots{nullptr, std::free};
+    size_t m_Mask;
+    size_t m_Limit;
+    std::atomic<size_t> m_Count{0};
+};
+
+struct ExplorerConfig {
+    int m_CyclesPerFrame = 15;
+    int m_MaxDepth = 600;             // frames
+    size_t m_BeamWidth = 0;           // states kept per depth, best score first; 0 keeps everything (BFS)
+    size_t m_MemoryLimit = 1ull << 30; // bytes for the hash set, frontiers and input history together
+    int m_Threads = 0;                // 0 uses every hardware thread
+};
+
+struct ExplorerProgress {
+    int m_Depth;
+    size_t m_Frontier;      // states at this depth
+    uint64_t m_Expanded;    // successors generated so far
+    uint64_t m_Unique;      // distinct states seen so far
+    double m_Seconds;
+    size_t m_Bytes;         // memory in use
+};
+
+struct ExplorerResult {
+    bool m_Found = false;
+    std::vector<uint16_t> m_Inputs;   // keypad bitmask per frame that reaches the goal from the start state
+    CHIP8Context m_State;             // the state that satisfied the goal, if found
+    int m_Depth = 0;                  // deepest level completed
+    uint64_t m_Expanded = 0;
+    uint64_t m_Unique = 0;
+    double m_Seconds = 0.0;
+    size_t m_PeakBytes = 0;
+    bool m_HitMemoryLimit = false;    // frontiers were cut or the hash set filled up
+};
+
+/**
+ * Searches for a sequence of keypad inputs that drives a machine into a goal state.
+ *
+ * At every frame each state branches 17 ways: no key, or one of the 16 keys held for the frame. Successors
+ * whose stateHash() was already seen are dropped. Expansion is spread over threads; each depth is finished
+ * before the next starts, so the first goal found is at the shallowest depth (BFS). With a beam width,
+ * only the best-scoring states of each depth are kept.
+ */
+class CHIP8Explorer {
+public:
+    using Goal = std::function<bool(const CHIP8Context&)>;
+    using Score = std::function<int64_t(const CHIP8Context&)>;
+    using Progress = std::function<void(const ExplorerProgress&)>;
+
+    explicit CHIP8Explorer(const ExplorerConfig& config) : m_Config(config) {}
+
+    /**
+     * @param start The state to search from. It is copied, never modified.
+     * @param goal Returns true for a state the search is looking for. Called from worker threads.
+     * @param score Ranks states for the beam; higher is better. May be empty for plain BFS. Called from worker threads.
+     * @param progress Called on the calling thread after every depth. May be empty.
+     */
+    ExplorerResult run(const CHIP8Context& start, const Goal& goal, const Score& score = Score(),
+                       const Progress& progress = Progress());
+
+private:
+    ExplorerConfig m_Config;
+};
+
+
+#endif //MY_CHIP_8_EMULATOR_CHIP8EXPLORER_H
@@ -0,0 +1,240 @@
+//
+// Binary execution traces. See CHIP8Trace.h for the format.
+//
+#include "CHIP8Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    const uint8_t TRACE_HEADER[8] = { 'C', '8', 'T', 'R', 1, 0, 0, 0 };
+    const size_t MAX_RECORD_SIZE = 2 + 2 + 2 + 1 + 16 + 2;
+}
+
+bool TraceRecord::operator==(const TraceRecord& other) const {
+    if (m_ProgramCounter != other.m_ProgramCounter || m_Opcode != other.m_Opcode ||
+        m_ChangedRegisters != other.m_ChangedRegisters || m_AddressIChanged != other.m_AddressIChanged) {
+        return false;
+    }
+    if (m_AddressIChanged && m_AddressI != other.m_AddressI) {
+        return false;
+    }
+    for (int i = 0; i < 16; ++i) {
+        if (((m_ChangedRegisters >> i) & 1) && m_Registers[i] != other.m_Registers[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TraceRecorder::TraceRecorder(size_t ringBytes) {
+    size_t capacity = 256;
+    while (capacity < ringBytes) {
+        capacity <<= 1;
+    }
+    m_Ring.resize(capacity);
+    m_Mask = capacity - 1;
+}
+
+TraceRecorder::~TraceRecorder() {
+    close();
+}
+
+bool TraceRecorder::open(const char* path) {
+    close();
+    m_File = std::fopen(path, "wb");
+    if (!m_File) {
+        perror("Failed to open trace file");
+        return false;
+    }
+    start();
+    return true;
+}
+
+void TraceRecorder::open(std::vector<uint8_t>& buffer) {
+    close();
+    m_Buffer = &buffer;
+    start();
+}
+
+void TraceRecorder::start() {
+    emit(TRACE_HEADER, sizeof(TRACE_HEADER));
+    m_Head.store(0, std::memory_order_relaxed);
+    m_Tail.store(0, std::memory_order_relaxed);
+    m_Stop.store(false, std::memory_order_relaxed);
+    m_Writer = std::thread(&TraceRecorder::writerLoop, this);
+}
+
+void TraceRecorder::close() {
+    if (!m_Writer.joinable()) {
+        return;
+    }
+
+    m_Stop.store(true, std::memory_order_release);
+    m_Writer.join();
+
+    if (m_File) {
+        std::fclose(m_File);
+        m_File = nullptr;
+    }
+    m_Buffer = nullptr;
+}
+
+void TraceRecorder::runCycles(CHIP8Context& chip8, int count, const CHIP8KeyEvent* events, size_t eventCount) {
+    chip8.m_BlockMapId = 0; // runs through execute(), which does not track writes over code
+    size_t next = 0;
+    for (int i = 0; i < count; i++) {
+        while (next < eventCount && events[next].cycle <= i) {
+            chip8.applyKeyEvent(events[next++]);
+        }
+        step(chip8);
+        chip8.tickTimers();
+    }
+
+    while (next < eventCount) {
+        chip8.applyKeyEvent(events[next++]);
+    }
+}
+
+void TraceRecorder::step(CHIP8Context& chip8) {
+    CHIP8Context::BYTE registers[16];
+    std::memcpy(registers, chip8.m_Registers, sizeof(registers));
+    const CHIP8Context::WORD addressI = chip8.m_AddressI;
+    const CHIP8Context::WORD pc = chip8.m_ProgramCounter;
+    const CHIP8Context::WORD opcode = static_cast<CHIP8Context::WORD>(
+        (chip8.m_GameMemory[pc & 0x0FFF] << 8) | chip8.m_GameMemory[(pc + 1) & 0x0FFF]);
+
+    chip8.execute();
+
+    uint8_t record[MAX_RECORD_SIZE];
+    uint8_t* out = record + 7;
+    uint16_t changed = 0;
+    for (int i = 0; i < 16; ++i) {
+        if (chip8.m_Registers[i] != registers[i]) {
+            changed |= static_cast<uint16_t>(1u << i);
+            *out++ = chip8.m_Registers[i];
+        }
+    }
+    const bool addressIChanged = chip8.m_AddressI != addressI;
+    if (addressIChanged) {
+        *out++ = chip8.m_AddressI & 0xFF;
+        *out++ = chip8.m_AddressI >> 8;
+    }
+
+    record[0] = pc & 0xFF;
+    record[1] = pc >> 8;
+    record[2] = opcode & 0xFF;
+    record[3] = opcode >> 8;
+    record[4] = changed & 0xFF;
+    record[5] = changed >> 8;
+    record[6] = addressIChanged ? 1 : 0;
+    const size_t size = static_cast<size_t>(out - record);
+
+    // Single producer: only this thread moves the head, so a relaxed load of our own index is enough.
+    const size_t head = m_Head.load(std::memory_order_relaxed);
+    if (m_Ring.size() - (head - m_Tail.load(std::memory_order_acquire)) < size) {
+        ++m_ProducerWaits;
+        while (m_Ring.size() - (head - m_Tail.load(std::memory_order_acquire)) < size) {
+            std::this_thread::yield();
+        }
+    }
+    for (size_t i = 0; i < size; ++i) {
+        m_Ring[(head + i) & m_Mask] = record[i];
+    }
+    m_Head.store(head + size, std::memory_order_release);
+    ++m_Records;
+}
+
+void TraceRecorder::writerLoop() {
+    while (!m_Stop.load(std::memory_order_acquire)) {
+        if (m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            continue;
+        }
+        drain();
+    }
+    drain();
+}
+
+void TraceRecorder::drain() {
+    const size_t head = m_Head.load(std::memory_order_acquire);
+    size_t tail = m_Tail.load(std::memory_order_relaxed);
+
+    while (tail != head) {
+        // Write up to the end of the ring, then wrap.
+        const size_t offset = tail & m_Mask;
+        const size_t contiguous = std::min(head - tail, m_Ring.size() - offset);
+        emit(&m_Ring[offset], contiguous);
+        tail += contiguous;
+    }
+    m_Tail.store(tail, std::memory_order_release);
+}
+
+void TraceRecorder::emit(const uint8_t* bytes, size_t size) {
+    if (m_File) {
+        std::fwrite(bytes, 1, size, m_File);
+    } else if (m_Buffer) {
+        m_Buffer->insert(m_Buffer->end(), bytes, bytes + size);
+    }
+}
+
+TraceReader::~TraceReader() {
+    if (m_File) {
+        std::fclose(m_File);
+    }
+}
+
+bool TraceReader::open(const char* path) {
+    m_File = std::fopen(path, "rb");
+    if (!m_File) {
+        return false;
+    }
+
+    uint8_t header[sizeof(TRACE_HEADER)];
+    return std::fread(header, 1, sizeof(header), m_File) == sizeof(header) &&
+           std::memcmp(header, TRACE_HEADER, 4) == 0;
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    uint8_t fixed[7];
+    if (std::fread(fixed, 1, sizeof(fixed), m_File) != sizeof(fixed)) {
+        return false;
+    }
+
+    record.m_ProgramCounter = static_cast<uint16_t>(fixed[0] | (fixed[1] << 8));
+    record.m_Opcode = static_cast<uint16_t>(fixed[2] | (fixed[3] << 8));
+    record.m_ChangedRegisters = static_cast<uint16_t>(fixed[4] | (fixed[5] << 8));
+    record.m_AddressIChanged = fixed[6] & 1;
+    std::memset(record.m_Registers, 0, sizeof(record.m_Registers));
+    record.m_AddressI = 0;
+
+    for (int i = 0; i < 16; ++i) {
+        if (((record.m_ChangedRegisters >> i) & 1) && std::fread(&record.m_Registers[i], 1, 1, m_File) != 1) {
+            return false;
+        }
+    }
+    if (record.m_AddressIChanged) {
+        uint8_t value[2];
+        if (std::fread(value, 1, 2, m_File) != 2) {
+            return false;
+        }
+        record.m_AddressI = static_cast<uint16_t>(value[0] | (value[1] << 8));
+    }
+
+    ++m_Index;
+    return true;
+}
+
+void formatTraceRecord(const TraceRecord& record, char* out, size_t size) {
+    int written = std::snprintf(out, size, "PC=0x%04X OP=%04X", record.m_ProgramCounter, record.m_Opcode);
+
+    for (int i = 0; i < 16 && written > 0 && static_cast<size_t>(written) < size; ++i) {
+        if ((record.m_ChangedRegisters >> i) & 1) {
+            written += std::snprintf(out + written, size - written, " V%X=%02X", i, record.m_Registers[i]);
+        }
+    }
+    if (record.m_AddressIChanged && written > 0 && static_cast<size_t>(written) < size) {
+        std::snprintf(out + written, size - written, " I=%03X", record.m_AddressI);
+    }
+}
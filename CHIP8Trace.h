@@ -0,0 +1,135 @@
+//
+// Binary execution traces: a recorder that costs nothing unless used, and a reader for the decoder tool.
+//
+// A trace file is an 8-byte header ("C8TR", version, reserved) followed by one variable-length record
+// per instruction, all little-endian:
+//
+//     u16 pc        address the opcode was fetched from
+//     u16 opcode
+//     u16 changed   bit N set if VN changed
+//     u8  flags     bit 0 set if I changed
+//     u8  value     new value of each changed register, in register order
+//     u16 I         new value of I, only if flags bit 0 is set
+//
+
+#ifndef MY_CHIP_8_EMULATOR_CHIP8TRACE_H
+#define MY_CHIP_8_EMULATOR_CHIP8TRACE_H
+
+#include "CHIP8.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+struct TraceRecord {
+    uint16_t m_ProgramCounter;
+    uint16_t m_Opcode;
+    uint16_t m_ChangedRegisters; // bit N set if VN changed
+    uint8_t m_Registers[16];     // new values; only entries with their bit set are meaningful
+    bool m_AddressIChanged;
+    uint16_t m_AddressI;
+
+    bool operator==(const TraceRecord& other) const;
+    bool operator!=(const TraceRecord& other) const { return !(*this == other); }
+};
+
+/**
+ * Records the instructions executed by one emulation thread. Records go into a lock-free
+ * single-producer ring; a background thread drains it to a file through stdio, or appends it to a
+ * caller's std::vector. Nothing is memory-mapped. Create one recorder per emulation thread.
+ *
+ * Tracing is opt-in per call: CHIP8Context::runCycles is untouched, and only TraceRecorder::runCycles
+ * pays for the register comparison and the ring write.
+ */
+class TraceRecorder {
+public:
+    /**
+     * @param ringBytes Ring buffer capacity, rounded up to a power of two.
+     */
+    explicit TraceRecorder(size_t ringBytes = 1 << 20);
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /**
+     * Starts writing a trace to a file.
+     * @param path The file to create.
+     * @return false if the file could not be opened.
+     */
+    bool open(const char* path);
+
+    /**
+     * Starts appending a trace to a memory buffer, which must outlive close().
+     * @param buffer Receives the same bytes a trace file would contain.
+     */
+    void open(std::vector<uint8_t>& buffer);
+
+    /**
+     * Flushes everything recorded so far and stops the writer thread.
+     */
+    void close();
+
+    /**
+     * Same as CHIP8Context::runCycles, recording every instruction.
+     */
+    void runCycles(CHIP8Context& chip8, int count, const CHIP8KeyEvent* events = nullptr, size_t eventCount = 0);
+
+    /**
+     * Executes and records a single instruction.
+     */
+    void step(CHIP8Context& chip8);
+
+    uint64_t m_Records = 0;
+    uint64_t m_ProducerWaits = 0; // times the emulator had to wait for the writer to make room
+
+private:
+    std::vector<uint8_t> m_Ring;
+    size_t m_Mask;
+    std::atomic<size_t> m_Head{0}; // written by the emulation thread
+    std::atomic<size_t> m_Tail{0}; // written by the writer thread
+    std::atomic<bool> m_Stop{false};
+    std::thread m_Writer;
+
+    FILE* m_File = nullptr;
+    std::vector<uint8_t>* m_Buffer = nullptr;
+
+    void start();
+    void writerLoop();
+    void drain();
+    void emit(const uint8_t* bytes, size_t size);
+};
+
+/**
+ * Reads a trace written by TraceRecorder.
+ */
+class TraceReader {
+public:
+    ~TraceReader();
+
+    /**
+     * @return false if the file is missing or does not start with a trace header.
+     */
+    bool open(const char* path);
+
+    /**
+     * @param record Receives the next record.
+     * @return false at the end of the trace.
+     */
+    bool next(TraceRecord& record);
+
+    uint64_t m_Index = 0; // number of records read so far
+
+private:
+    FILE* m_File = nullptr;
+};
+
+/**
+ * Formats a record as one line of text, e.g. "PC=0x0202 OP=6B0C VB=0C".
+ */
+void formatTraceRecord(const TraceRecord& record, char* out, size_t size);
+
+
+#endif //MY_CHIP_8_EMULATOR_CHIP8TRACE_H
@@ -0,0 +1,321 @@
+//
+// Two-player rollback netplay over UDP.
+//
+#include "Netplay.h"
+#include "Telemetry.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+constexpr int NetplaySession::ROLLBACK_WINDOW;
+
+namespace {
+    const uint32_t PACKET_MAGIC = 0x504E3843; // "C8NP"
+    const size_t HEADER_SIZE = 4 + 4 + 4 + 1 + 4 + 8;
+    const size_t MAX_PACKET_SIZE = HEADER_SIZE + 2 * NetplaySession::ROLLBACK_WINDOW;
+
+    void put16(uint8_t*& out, uint16_t value) {
+        *out++ = value & 0xFF;
+        *out++ = value >> 8;
+    }
+
+    void put32(uint8_t*& out, uint32_t value) {
+        put16(out, value & 0xFFFF);
+        put16(out, value >> 16);
+    }
+
+    void put64(uint8_t*& out, uint64_t value) {
+        put32(out, value & 0xFFFFFFFFu);
+        put32(out, value >> 32);
+    }
+
+    uint16_t get16(const uint8_t*& in) {
+        const uint16_t value = static_cast<uint16_t>(in[0] | (in[1] << 8));
+        in += 2;
+        return value;
+    }
+
+    uint32_t get32(const uint8_t*& in) {
+        const uint32_t low = get16(in);
+        return low | (static_cast<uint32_t>(get16(in)) << 16);
+    }
+
+    uint64_t get64(const uint8_t*& in) {
+        const uint64_t low = get32(in);
+        return low | (static_cast<uint64_t>(get32(in)) << 32);
+    }
+}
+
+NetplaySession::NetplaySession()
+    : m_States(ROLLBACK_WINDOW) {
+    std::memset(&m_RemoteAddress, 0, sizeof(m_RemoteAddress));
+    std::memset(m_LocalInput, 0, sizeof(m_LocalInput));
+    std::memset(m_RemoteInput, 0, sizeof(m_RemoteInput));
+    std::memset(m_PredictedInput, 0, sizeof(m_PredictedInput));
+    std::memset(m_ConfirmedHash, 0, sizeof(m_ConfirmedHash));
+}
+
+NetplaySession::~NetplaySession() {
+    if (m_Socket >= 0) {
+        flushOutgoing(true);
+        ::close(m_Socket);
+    }
+}
+
+bool NetplaySession::open(const NetplayConfig& config) {
+    m_Config = config;
+    m_RandomState ^= static_cast<uint32_t>(config.m_LocalPort) * 0x85EBCA6Bu;
+
+    m_Socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_Socket < 0) {
+        perror("Netplay: socket");
+        return false;
+    }
+
+    const int flags = fcntl(m_Socket, F_GETFL, 0);
+    fcntl(m_Socket, F_SETFL, flags | O_NONBLOCK);
+
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(config.m_LocalPort);
+    if (bind(m_Socket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) {
+        perror("Netplay: bind");
+        return false;
+    }
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(config.m_RemoteHost.c_str(), nullptr, &hints, &result) != 0 || !result) {
+        std::fprintf(stderr, "Netplay: could not resolve %s\n", config.m_RemoteHost.c_str());
+        return false;
+    }
+    std::memcpy(&m_RemoteAddress, result->ai_addr, sizeof(m_RemoteAddress));
+    m_RemoteAddress.sin_port = htons(config.m_RemotePort);
+    freeaddrinfo(result);
+
+    return true;
+}
+
+bool NetplaySession::advanceFrame(CHIP8Context& chip8, uint16_t localKeys) {
+    if (!m_Started) {
+        m_States[0] = chip8;
+        m_Started = true;
+    }
+
+    receive();
+    rollback(chip8);
+    recordConfirmedHashes(chip8);
+
+    // Running another frame would push a snapshot we may still need out of the window, or leave
+    // the peer needing input we can no longer resend.
+    const int64_t limit = ROLLBACK_WINDOW - 1;
+    if (static_cast<int64_t>(m_Frame) - m_RemoteConfirmed >= limit || static_cast<int64_t>(m_Frame) - m_PeerAcked >= limit) {
+        ++m_StalledFrames;
+        send();
+        return false;
+    }
+
+    m_LocalInput[m_Frame % ROLLBACK_WINDOW] = localKeys;
+    simulate(chip8, m_Frame);
+    ++m_Frame;
+
+    recordConfirmedHashes(chip8);
+    send();
+    return true;
+}
+
+void NetplaySession::poll(CHIP8Context& chip8) {
+    if (!m_Started) {
+        m_States[0] = chip8;
+        m_Started = true;
+    }
+
+    receive();
+    rollback(chip8);
+    recordConfirmedHashes(chip8);
+    send();
+}
+
+uint16_t NetplaySession::remoteInputFor(uint32_t frame) const {
+    if (frame < m_RemoteConfirmed) {
+        return m_RemoteInput[frame % (2 * ROLLBACK_WINDOW)];
+    }
+
+    // Prediction: the remote player keeps holding whatever they held last.
+    return m_RemoteConfirmed > 0 ? m_RemoteInput[(m_RemoteConfirmed - 1) % (2 * ROLLBACK_WINDOW)] : 0;
+}
+
+void NetplaySession::simulate(CHIP8Context& chip8, uint32_t frame) {
+    const uint16_t remote = remoteInputFor(frame);
+    m_PredictedInput[frame % ROLLBACK_WINDOW] = remote;
+
+    // Both peers see the same combined keypad, so player order does not matter.
+    chip8.m_Keypad = m_LocalInput[frame % ROLLBACK_WINDOW] | remote;
+    chip8.runCycles(m_Config.m_CyclesPerFrame);
+
+    m_States[(frame + 1) % ROLLBACK_WINDOW] = chip8;
+}
+
+void NetplaySession::receive() {
+    flushOutgoing(false);
+
+    uint8_t buffer[MAX_PACKET_SIZE];
+    while (true) {
+        const ssize_t size = recv(m_Socket, buffer, sizeof(buffer), 0);
+        if (size < 0) {
+            break; // EWOULDBLOCK: nothing left to read
+        }
+        if (static_cast<size_t>(size) < HEADER_SIZE) {
+            continue;
+        }
+
+        const uint8_t* in = buffer;
+        if (get32(in) != PACKET_MAGIC) {
+            continue;
+        }
+        const uint32_t ack = get32(in);
+        const uint32_t start = get32(in);
+        const uint8_t count = *in++;
+        const uint32_t hashFrame = get32(in);
+        const uint64_t hash = get64(in);
+        if (static_cast<size_t>(size) < HEADER_SIZE + 2u * count) {
+            continue;
+        }
+
+        if (ack > m_PeerAcked) {
+            m_PeerAcked = ack;
+        }
+        if (hashFrame != UINT32_MAX && (m_PeerHashFrame == UINT32_MAX || hashFrame > m_PeerHashFrame)) {
+            m_PeerHashFrame = hashFrame;
+            m_PeerHash = hash;
+        }
+
+        // Inputs are always sent as a contiguous run starting at or before the frame we need next.
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint32_t frame = start + i;
+            const uint16_t input = get16(in);
+            if (frame != m_RemoteConfirmed || frame >= m_Frame + ROLLBACK_WINDOW) {
+                continue;
+            }
+
+            m_RemoteInput[frame % (2 * ROLLBACK_WINDOW)] = input;
+            ++m_RemoteConfirmed;
+
+            if (frame < m_Frame && m_PredictedInput[frame % ROLLBACK_WINDOW] != input && frame < m_RollbackFrom) {
+                m_RollbackFrom = frame;
+            }
+        }
+    }
+}
+
+void NetplaySession::rollback(CHIP8Context& chip8) {
+    if (m_RollbackFrom >= m_Frame) {
+        m_RollbackFrom = UINT32_MAX;
+        return;
+    }
+
+    CHIP8_PROFILE_SCOPE("rollback");
+    const int depth = static_cast<int>(m_Frame - m_RollbackFrom);
+    ++m_Rollbacks;
+    m_ResimulatedFrames += depth;
+    if (depth > m_MaxRollbackFrames) {
+        m_MaxRollbackFrames = depth;
+    }
+
+    chip8 = m_States[m_RollbackFrom % ROLLBACK_WINDOW];
+    for (uint32_t frame = m_RollbackFrom; frame < m_Frame; ++frame) {
+        simulate(chip8, frame);
+    }
+    m_RollbackFrom = UINT32_MAX;
+}
+
+void NetplaySession::recordConfirmedHashes(const CHIP8Context& chip8) {
+    const uint32_t confirmed = m_RemoteConfirmed < m_Frame ? m_RemoteConfirmed : m_Frame;
+
+    for (; m_Hashed < confirmed; ++m_Hashed) {
+        const uint32_t next = m_Hashed + 1;
+        const uint64_t hash = next == m_Frame ? chip8.stateHash() : m_States[next % ROLLBACK_WINDOW].stateHash();
+        m_ConfirmedHash[m_Hashed % ROLLBACK_WINDOW] = hash;
+        if (m_ConfirmedHashLog) {
+            m_ConfirmedHashLog->push_back(hash);
+        }
+    }
+
+    if (m_PeerHashFrame != UINT32_MAX && m_PeerHashFrame < m_Hashed && m_PeerHashFrame + ROLLBACK_WINDOW > m_Hashed) {
+        if (m_ConfirmedHash[m_PeerHashFrame % ROLLBACK_WINDOW] != m_PeerHash && !m_Desynced) {
+            m_Desynced = true;
+            std::fprintf(stderr, "Netplay (player %d): desync detected at frame %u\n",
+                         m_Config.m_LocalPlayer, m_PeerHashFrame);
+        }
+    }
+}
+
+void NetplaySession::send() {
+    // Resend everything the peer has not acknowledged; a lost packet is covered by the next one.
+    uint32_t start = m_PeerAcked;
+    if (m_Frame > ROLLBACK_WINDOW && start < m_Frame - ROLLBACK_WINDOW) {
+        start = m_Frame - ROLLBACK_WINDOW;
+    }
+    const uint32_t count = m_Frame - start;
+
+    PendingPacket packet;
+    packet.m_Bytes.resize(HEADER_SIZE + 2 * count);
+    uint8_t* out = packet.m_Bytes.data();
+    put32(out, PACKET_MAGIC);
+    put32(out, m_RemoteConfirmed);
+    put32(out, start);
+    *out++ = static_cast<uint8_t>(count);
+    put32(out, m_Hashed > 0 ? m_Hashed - 1 : UINT32_MAX);
+    put64(out, m_Hashed > 0 ? m_ConfirmedHash[(m_Hashed - 1) % ROLLBACK_WINDOW] : 0);
+    for (uint32_t frame = start; frame < m_Frame; ++frame) {
+        put16(out, m_LocalInput[frame % ROLLBACK_WINDOW]);
+    }
+
+    ++m_PacketsSent;
+    if (m_Config.m_SimulatedLossRate > 0.0 && nextRandom() < m_Config.m_SimulatedLossRate) {
+        ++m_PacketsDropped;
+        return;
+    }
+
+    packet.m_DeliverAtMs = nowMs() + m_Config.m_SimulatedLatencyMs + m_Config.m_SimulatedJitterMs * nextRandom();
+    m_Outgoing.push_back(std::move(packet));
+    flushOutgoing(false);
+}
+
+void NetplaySession::flushOutgoing(bool force) {
+    const double now = nowMs();
+
+    // Jitter can reorder packets; the receiver handles that, so deliver whatever is due.
+    for (auto it = m_Outgoing.begin(); it != m_Outgoing.end();) {
+        if (force || it->m_DeliverAtMs <= now) {
+            sendto(m_Socket, it->m_Bytes.data(), it->m_Bytes.size(), 0,
+                   reinterpret_cast<const sockaddr*>(&m_RemoteAddress), sizeof(m_RemoteAddress));
+            it = m_Outgoing.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+double NetplaySession::nowMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double NetplaySession::nextRandom() {
+    m_RandomState ^= m_RandomState << 13;
+    m_RandomState ^= m_RandomState >> 17;
+    m_RandomState ^= m_RandomState << 5;
+    return (m_RandomState >> 8) / static_cast<double>(1u << 24);
+}
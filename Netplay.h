@@ -0,0 +1,122 @@
+//
+// Two-player rollback netplay over UDP.
+//
+// Both peers run the same machine with the combined input of both players. Local input is applied
+// immediately; the remote player's input is predicted to be whatever they held last. When the real
+// remote input arrives and differs from the prediction, the machine is restored to the snapshot taken
+// at the start of that frame and the frames since are simulated again.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_NETPLAY_H
+#define MY_CHIP_8_EMULATOR_NETPLAY_H
+
+#include "CHIP8.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+
+struct NetplayConfig {
+    int m_LocalPlayer = 0;          // 0 or 1; only used to tell the two peers apart in logs
+    uint16_t m_LocalPort = 0;
+    std::string m_RemoteHost = "127.0.0.1";
+    uint16_t m_RemotePort = 0;
+    int m_CyclesPerFrame = 15;
+
+    // Impairments applied to outgoing packets, for testing on a single machine over loopback.
+    double m_SimulatedLatencyMs = 0.0;
+    double m_SimulatedJitterMs = 0.0;
+    double m_SimulatedLossRate = 0.0; // 0..1
+};
+
+class NetplaySession {
+public:
+    // Frames of input and snapshot history. This bounds how far back a misprediction can be
+    // corrected; a peer that falls further behind makes the other one wait.
+    static constexpr int ROLLBACK_WINDOW = 64;
+
+    NetplaySession();
+    ~NetplaySession();
+
+    NetplaySession(const NetplaySession&) = delete;
+    NetplaySession& operator=(const NetplaySession&) = delete;
+
+    /**
+     * Binds the local UDP port and resolves the remote peer.
+     * @param config Ports, peer address and optional network impairments.
+     * @return false if the socket could not be set up. The reason is printed with perror.
+     */
+    bool open(const NetplayConfig& config);
+
+    /**
+     * Exchanges input with the peer, rolls back and re-simulates if an earlier prediction was wrong,
+     * then runs one new frame. Both peers must start from identical machines, including the random seed.
+     * @param chip8 The machine to advance.
+     * @param localKeys The keys held by the local player this frame, as a keypad bitmask.
+     * @return false if the frame was not run because the peer is too far behind; call again next frame.
+     */
+    bool advanceFrame(CHIP8Context& chip8, uint16_t localKeys);
+
+    /**
+     * Sends and receives without advancing, e.g. while the window is paused.
+     */
+    void poll(CHIP8Context& chip8);
+
+    uint32_t m_Frame = 0; // next frame to run
+
+    // Statistics.
+    uint64_t m_Rollbacks = 0;
+    uint64_t m_ResimulatedFrames = 0;
+    int m_MaxRollbackFrames = 0;
+    uint64_t m_StalledFrames = 0;
+    uint64_t m_PacketsSent = 0;
+    uint64_t m_PacketsDropped = 0; // by the loss simulation
+    bool m_Desynced = false;       // the peer reported a different state hash for a confirmed frame
+
+    // When set, receives the state hash after every confirmed frame, in order. Used to check that
+    // both peers ended up with identical histories.
+    std::vector<uint64_t>* m_ConfirmedHashLog = nullptr;
+
+private:
+    struct PendingPacket {
+        double m_DeliverAtMs;
+        std::vector<uint8_t> m_Bytes;
+    };
+
+    NetplayConfig m_Config;
+    int m_Socket = -1;
+    sockaddr_in m_RemoteAddress;
+
+    std::vector<CHIP8Context> m_States;       // m_States[f % W] is the machine at the start of frame f
+    uint16_t m_LocalInput[ROLLBACK_WINDOW];
+    uint16_t m_RemoteInput[2 * ROLLBACK_WINDOW]; // confirmed remote input; the peer may run up to a window ahead
+    uint16_t m_PredictedInput[ROLLBACK_WINDOW]; // remote input each simulated frame actually used
+    uint64_t m_ConfirmedHash[ROLLBACK_WINDOW];
+
+    uint32_t m_RemoteConfirmed = 0; // remote input is known for every frame below this
+    uint32_t m_PeerAcked = 0;       // the peer has our input for every frame below this
+    uint32_t m_Hashed = 0;          // confirmed hashes recorded for every frame below this
+    uint32_t m_PeerHashFrame = UINT32_MAX;
+    uint64_t m_PeerHash = 0;
+    uint32_t m_RollbackFrom = UINT32_MAX;
+    bool m_Started = false;
+
+    std::deque<PendingPacket> m_Outgoing; // delayed by the latency simulation
+    uint32_t m_RandomState = 0x9E3779B9u;
+
+    uint16_t remoteInputFor(uint32_t frame) const;
+    void simulate(CHIP8Context& chip8, uint32_t frame);
+    void receive();
+    void rollback(CHIP8Context& chip8);
+    void recordConfirmedHashes(const CHIP8Context& chip8);
+    void send();
+    void flushOutgoing(bool force);
+    double nowMs() const;
+    double nextRandom();
+};
+
+
+#endif //MY_CHIP_8_EMULATOR_NETPLAY_H
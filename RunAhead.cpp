@@ -0,0 +1,32 @@
+//
+// Run-ahead: show the machine as it will be a few frames from now to hide the ROM's own input lag.
+//
+#include "RunAhead.h"
+#include "Telemetry.h"
+
+#include <chrono>
+
+RunAhead::RunAhead(int frames, int cyclesPerFrame)
+    : m_Frames(frames), m_CyclesPerFrame(cyclesPerFrame) {
+}
+
+const CHIP8Context& RunAhead::lookAhead(const CHIP8Context& chip8) {
+    if (m_Frames <= 0) {
+        return chip8;
+    }
+
+    CHIP8_PROFILE_SCOPE("runAhead");
+    const auto start = std::chrono::steady_clock::now();
+
+    // The context is trivially copyable, so a snapshot is one memcpy-sized copy. Running the copy
+    // and throwing it away is the same as snapshot, run, restore, minus the restore.
+    m_Ahead = chip8;
+    m_Ahead.runCycles(m_Frames * m_CyclesPerFrame);
+
+    m_LastOverheadMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    m_AverageOverheadMicros = m_AverageOverheadMicros == 0.0
+        ? m_LastOverheadMicros
+        : m_AverageOverheadMicros * 0.95 + m_LastOverheadMicros * 0.05;
+
+    return m_Ahead;
+}
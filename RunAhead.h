@@ -0,0 +1,38 @@
+//
+// Run-ahead: show the machine as it will be a few frames from now to hide the ROM's own input lag.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_RUNAHEAD_H
+#define MY_CHIP_8_EMULATOR_RUNAHEAD_H
+
+#include "CHIP8.h"
+
+struct RunAhead {
+    /**
+     * @param frames How many frames to run ahead. 0 disables run-ahead.
+     * @param cyclesPerFrame The number of instructions in one frame.
+     */
+    RunAhead(int frames, int cyclesPerFrame);
+
+    /**
+     * Snapshots the machine after the caller has advanced it by one frame, runs the snapshot m_Frames
+     * further with the keys currently held, and returns that future state for display. chip8 itself is
+     * left untouched, so however it was advanced (traced, predecoded or plain) is unaffected.
+     * @param chip8 The machine, already advanced by this frame.
+     * @return The state to display: chip8 itself if run-ahead is off. Valid until the next call.
+     */
+    const CHIP8Context& lookAhead(const CHIP8Context& chip8);
+
+    int m_Frames;
+    int m_CyclesPerFrame;
+
+    // Cost of the snapshot and the speculative frames, excluding the real frame.
+    double m_LastOverheadMicros = 0.0;
+    double m_AverageOverheadMicros = 0.0; // exponential moving average
+
+private:
+    CHIP8Context m_Ahead;
+};
+
+
+#endif //MY_CHIP_8_EMULATOR_RUNAHEAD_H
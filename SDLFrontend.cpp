@@ -0,0 +1,134 @@
+//
+// SDL2 presentation and input for a CHIP8Context.
+//
+#include "SDLFrontend.h"
+
+#include <algorithm>
+#include <cstring>
+
+void render(const CHIP8Context& chip8, SDL_Renderer* renderer) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black
+    SDL_RenderClear(renderer);
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White
+    int scale = 10; // 64*10=640, 32*10=320
+    for (int y = 0; y < 32; ++y) {
+        for (int x = 0; x < 64; ++x) {
+            if (chip8.m_ScreenData[x][y]) {
+                SDL_Rect rect = { x * scale, y * scale, scale, scale };
+                SDL_RenderFillRect(renderer, &rect);
+            }
+        }
+    }
+}
+
+KeyMap defaultKeyMap() {
+    KeyMap keyMap;
+
+    keyMap.m_Keys[0x1] = SDL_SCANCODE_1;
+    keyMap.m_Keys[0x2] = SDL_SCANCODE_2;
+    keyMap.m_Keys[0x3] = SDL_SCANCODE_3;
+    keyMap.m_Keys[0xC] = SDL_SCANCODE_4;
+
+    keyMap.m_Keys[0x4] = SDL_SCANCODE_Q;
+    keyMap.m_Keys[0x5] = SDL_SCANCODE_W;
+    keyMap.m_Keys[0x6] = SDL_SCANCODE_E;
+    keyMap.m_Keys[0xD] = SDL_SCANCODE_R;
+
+    keyMap.m_Keys[0x7] = SDL_SCANCODE_A;
+    keyMap.m_Keys[0x8] = SDL_SCANCODE_S;
+    keyMap.m_Keys[0x9] = SDL_SCANCODE_D;
+    keyMap.m_Keys[0xE] = SDL_SCANCODE_F;
+
+    keyMap.m_Keys[0xA] = SDL_SCANCODE_Z;
+    keyMap.m_Keys[0x0] = SDL_SCANCODE_X;
+    keyMap.m_Keys[0xB] = SDL_SCANCODE_C;
+    keyMap.m_Keys[0xF] = SDL_SCANCODE_V;
+
+    keyMap.m_TurboKey = SDL_SCANCODE_TAB;
+
+    return keyMap;
+}
+
+bool parseKeyMap(const char* spec, KeyMap& keyMap) {
+    KeyMap parsed = keyMap;
+    int key = 0;
+    const char* start = spec;
+
+    while (true) {
+        const char* end = std::strchr(start, ',');
+        const size_t length = end ? static_cast<size_t>(end - start) : std::strlen(start);
+
+        char name[32];
+        if (key >= 16 || length == 0 || length >= sizeof(name)) {
+            return false;
+        }
+        std::memcpy(name, start, length);
+        name[length] = '\0';
+
+        parsed.m_Keys[key] = SDL_GetScancodeFromName(name);
+        if (parsed.m_Keys[key] == SDL_SCANCODE_UNKNOWN) {
+            return false;
+        }
+        ++key;
+
+        if (!end) {
+            break;
+        }
+        start = end + 1;
+    }
+
+    if (key != 16) {
+        return false;
+    }
+    keyMap = parsed;
+    return true;
+}
+
+void processInput(const KeyMap& keyMap, Uint32 windowStart, Uint32 windowEnd, int cyclesPerFrame,
+                  std::vector<CHIP8KeyEvent>& events, bool& toggleTurbo, bool& running) {
+    events.clear();
+    toggleTurbo = false;
+    const Uint32 windowLength = windowEnd > windowStart ? windowEnd - windowStart : 1;
+
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        if (e.type == SDL_QUIT) {
+            running = false;
+            continue;
+        }
+
+        if ((e.type != SDL_KEYDOWN && e.type != SDL_KEYUP) || e.key.repeat) {
+            continue;
+        }
+
+        if (e.key.keysym.scancode == keyMap.m_TurboKey) {
+            toggleTurbo |= e.type == SDL_KEYDOWN;
+            continue;
+        }
+
+        for (int key = 0; key < 16; ++key) {
+            if (keyMap.m_Keys[key] != e.key.keysym.scancode) {
+                continue;
+            }
+
+            // Place the event at the same relative point of the batch as it had in the window.
+            const Uint32 offset = e.key.timestamp > windowStart ? e.key.timestamp - windowStart : 0;
+            int cycle = static_cast<int>(static_cast<uint64_t>(offset) * cyclesPerFrame / windowLength);
+            if (cycle >= cyclesPerFrame) {
+                cycle = cyclesPerFrame - 1;
+            }
+
+            CHIP8KeyEvent event;
+            event.cycle = static_cast<uint16_t>(cycle);
+            event.key = static_cast<uint8_t>(key);
+            event.pressed = e.type == SDL_KEYDOWN;
+            events.push_back(event);
+        }
+    }
+
+    // SDL delivers events in timestamp order, but clamping can tie them; keep that order stable.
+    std::stable_sort(events.begin(), events.end(), [](const CHIP8KeyEvent& a, const CHIP8KeyEvent& b) {
+        return a.cycle < b.cycle;
+    });
+}
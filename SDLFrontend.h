@@ -0,0 +1,60 @@
+//
+// SDL2 presentation and input for a CHIP8Context. The emulator core itself has no SDL dependency.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_SDLFRONTEND_H
+#define MY_CHIP_8_EMULATOR_SDLFRONTEND_H
+
+#include "CHIP8.h"
+
+#include <vector>
+
+#include "SDL2/SDL.h"
+
+/**
+ * Host keys for the 16 CHIP-8 keys. m_Keys[N] is the scancode that drives keypad key N.
+ */
+struct KeyMap {
+    SDL_Scancode m_Keys[16];
+    SDL_Scancode m_TurboKey; // toggles fast-forward
+};
+
+/**
+ * @return The usual layout: 1234/QWER/ASDF/ZXCV mapped onto 123C/456D/789E/A0BF, with Tab for fast-forward.
+ */
+KeyMap defaultKeyMap();
+
+/**
+ * Parses a key map given as 16 comma separated SDL key names in keypad order 0..F,
+ * for example "X,1,2,3,Q,W,E,A,S,D,Z,C,4,R,F,V".
+ * @param spec The key map description.
+ * @param keyMap Receives the parsed map. Left untouched on failure.
+ * @return false if there are not exactly 16 names or a name is unknown to SDL.
+ */
+bool parseKeyMap(const char* spec, KeyMap& keyMap);
+
+/**
+ * Draws the CHIP-8 screen, scaled 10x. Call SDL_RenderPresent afterwards to show it; it is kept
+ * separate so that fast-forward can run several frames per present.
+ * @param chip8 The machine whose screen is drawn.
+ * @param renderer The renderer to draw with.
+ */
+void render(const CHIP8Context& chip8, SDL_Renderer* renderer);
+
+/**
+ * Drains pending SDL events and converts mapped key presses and releases into keypad events.
+ * Each event keeps its position within the input window, scaled to a cycle of the next
+ * instruction batch, so ordering is preserved and taps shorter than a frame are not lost.
+ * @param keyMap The host key for each keypad key.
+ * @param windowStart SDL tick at which the input window (normally the previous frame) began.
+ * @param windowEnd SDL tick at which the input window ended.
+ * @param cyclesPerFrame The number of instructions in the batch the events will be applied to.
+ * @param events Cleared, then filled with events sorted by cycle.
+ * @param toggleTurbo Set to true if the fast-forward key was pressed.
+ * @param running Set to false when the window is closed.
+ */
+void processInput(const KeyMap& keyMap, Uint32 windowStart, Uint32 windowEnd, int cyclesPerFrame,
+                  std::vector<CHIP8KeyEvent>& events, bool& toggleTurbo, bool& running);
+
+
+#endif //MY_CHIP_8_EMULATOR_SDLFRONTEND_H
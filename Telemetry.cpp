@@ -0,0 +1,189 @@
+//
+// Phase timing telemetry. See Telemetry.h.
+//
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace {
+    struct Event {
+        std::atomic<const char*> m_Name;
+        std::atomic<uint64_t> m_Start;
+        std::atomic<uint64_t> m_End;
+    };
+
+    // A single-writer ring. The owning thread publishes each event by advancing m_Head; readers copy
+    // events out and then discard any the writer may have overwritten while they were copying.
+    struct Buffer {
+        Event m_Events[TELEMETRY_EVENTS_PER_THREAD];
+        std::atomic<uint64_t> m_Head;
+        int m_Id;
+    };
+
+    struct Recorded {
+        const char* m_Name;
+        uint64_t m_Start;
+        uint64_t m_End;
+        int m_Thread;
+    };
+
+    // Buffers are never freed: a thread that exits hands its buffer to the next new thread, so the
+    // explorer's short-lived workers reuse a handful of buffers and exports still see their events.
+    struct Registry {
+        std::mutex m_Mutex;
+        std::vector<std::unique_ptr<Buffer>> m_Buffers;
+        std::vector<Buffer*> m_Free;
+    };
+
+    Registry& registry() {
+        static Registry* registry = new Registry(); // leaked so it outlives thread_local destructors at exit
+        return *registry;
+    }
+
+    struct BufferOwner {
+        Buffer* m_Buffer = nullptr;
+
+        ~BufferOwner() {
+            if (m_Buffer) {
+                Registry& r = registry();
+                std::lock_guard<std::mutex> lock(r.m_Mutex);
+                r.m_Free.push_back(m_Buffer);
+            }
+        }
+    };
+
+    thread_local BufferOwner t_Owner;
+
+    Buffer& threadBuffer() {
+        if (!t_Owner.m_Buffer) {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.m_Mutex);
+            if (!r.m_Free.empty()) {
+                t_Owner.m_Buffer = r.m_Free.back();
+                r.m_Free.pop_back();
+            } else {
+                r.m_Buffers.emplace_back(new Buffer());
+                r.m_Buffers.back()->m_Id = static_cast<int>(r.m_Buffers.size());
+                t_Owner.m_Buffer = r.m_Buffers.back().get();
+            }
+        }
+        return *t_Owner.m_Buffer;
+    }
+
+    // Copies out up to the last limit events of every buffer.
+    void collect(std::vector<Recorded>& out, size_t limit) {
+        limit = std::min(limit, TELEMETRY_EVENTS_PER_THREAD);
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.m_Mutex);
+        for (const std::unique_ptr<Buffer>& buffer : r.m_Buffers) {
+            const uint64_t head = buffer->m_Head.load(std::memory_order_acquire);
+            const uint64_t first = head > limit ? head - limit : 0;
+            const size_t copied = out.size();
+            for (uint64_t i = first; i < head; ++i) {
+                const Event& event = buffer->m_Events[i % TELEMETRY_EVENTS_PER_THREAD];
+                out.push_back(Recorded{event.m_Name.load(std::memory_order_relaxed),
+                                       event.m_Start.load(std::memory_order_relaxed),
+                                       event.m_End.load(std::memory_order_relaxed), buffer->m_Id});
+            }
+
+            // Event i is intact only if the writer has not started on event i + capacity.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t after = buffer->m_Head.load(std::memory_order_relaxed);
+            const uint64_t intactFrom = after + 1 > TELEMETRY_EVENTS_PER_THREAD ? after + 1 - TELEMETRY_EVENTS_PER_THREAD : 0;
+            if (intactFrom > first) {
+                const size_t torn = static_cast<size_t>(std::min(intactFrom, head) - first);
+                out.erase(out.begin() + copied, out.begin() + copied + torn);
+            }
+        }
+    }
+
+    double percentileMicros(const std::vector<uint64_t>& sorted, double fraction) {
+        size_t rank = static_cast<size_t>(fraction * sorted.size() + 0.999999);
+        rank = std::max<size_t>(rank, 1);
+        return sorted[std::min(rank, sorted.size()) - 1] / 1000.0;
+    }
+}
+
+uint64_t telemetryNow() {
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+void recordTelemetryEvent(const char* name, uint64_t start, uint64_t end) {
+    Buffer& buffer = threadBuffer();
+    const uint64_t head = buffer.m_Head.load(std::memory_order_relaxed);
+
+    // Orders the previous m_Head store before the overwrite, for readers checking m_Head afterwards.
+    std::atomic_thread_fence(std::memory_order_release);
+    Event& event = buffer.m_Events[head % TELEMETRY_EVENTS_PER_THREAD];
+    event.m_Name.store(name, std::memory_order_relaxed);
+    event.m_Start.store(start, std::memory_order_relaxed);
+    event.m_End.store(end, std::memory_order_relaxed);
+    buffer.m_Head.store(head + 1, std::memory_order_release);
+}
+
+std::vector<TelemetryPhaseSummary> telemetrySummary(size_t recentPerThread) {
+    std::vector<Recorded> events;
+    collect(events, recentPerThread);
+
+    // Grouped by text rather than pointer: the same literal may live at different addresses per translation unit.
+    std::map<std::string, std::pair<const char*, std::vector<uint64_t>>> phases;
+    for (const Recorded& event : events) {
+        auto& phase = phases[event.m_Name];
+        phase.first = event.m_Name;
+        phase.second.push_back(event.m_End - event.m_Start);
+    }
+
+    std::vector<TelemetryPhaseSummary> summary;
+    for (auto& entry : phases) {
+        std::vector<uint64_t>& durations = entry.second.second;
+        std::sort(durations.begin(), durations.end());
+        summary.push_back(TelemetryPhaseSummary{entry.second.first, durations.size(),
+                                                percentileMicros(durations, 0.50), percentileMicros(durations, 0.95),
+                                                percentileMicros(durations, 0.99), durations.back() / 1000.0});
+    }
+    return summary;
+}
+
+void printTelemetrySummary(FILE* out, size_t recentPerThread) {
+    std::fprintf(out, "%-16s %9s %10s %10s %10s %10s\n", "phase", "count", "p50 us", "p95 us", "p99 us", "max us");
+    for (const TelemetryPhaseSummary& phase : telemetrySummary(recentPerThread)) {
+        std::fprintf(out, "%-16s %9llu %10.1f %10.1f %10.1f %10.1f\n", phase.m_Name,
+                     static_cast<unsigned long long>(phase.m_Count), phase.m_P50Micros, phase.m_P95Micros,
+                     phase.m_P99Micros, phase.m_MaxMicros);
+    }
+}
+
+bool writeTelemetryTrace(const char* path) {
+    std::vector<Recorded> events;
+    collect(events, TELEMETRY_EVENTS_PER_THREAD);
+    std::sort(events.begin(), events.end(), [](const Recorded& a, const Recorded& b) { return a.m_Start < b.m_Start; });
+
+    FILE* out = std::fopen(path, "w");
+    if (!out) {
+        std::perror(path);
+        return false;
+    }
+
+    std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    const char* separator = "\n";
+    for (const Recorded& event : events) {
+        // Phase names are identifiers from the source, so they need no JSON escaping.
+        std::fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"chip8\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                          "\"ts\":%.3f,\"dur\":%.3f}",
+                     separator, event.m_Name, event.m_Thread, event.m_Start / 1000.0,
+                     (event.m_End - event.m_Start) / 1000.0);
+        separator = ",\n";
+    }
+    std::fprintf(out, "\n]}\n");
+
+    const bool ok = std::ferror(out) == 0;
+    return std::fclose(out) == 0 && ok;
+}
@@ -0,0 +1,87 @@
+//
+// Phase timing telemetry: scoped timers that record into per-thread buffers, exported as Chrome trace_event
+// JSON and summarized as percentiles. Compiled in only with CHIP8_TELEMETRY; otherwise the scopes vanish.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_TELEMETRY_H
+#define MY_CHIP_8_EMULATOR_TELEMETRY_H
+
+#ifdef CHIP8_TELEMETRY
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Times the enclosing scope and records it as one event on the calling thread.
+ * @param name A string literal naming the phase. Only the pointer is stored.
+ */
+#define CHIP8_PROFILE_SCOPE(name) TelemetryScope CHIP8_TELEMETRY_JOIN(telemetryScope, __LINE__)(name)
+#define CHIP8_TELEMETRY_JOIN(a, b) CHIP8_TELEMETRY_JOIN2(a, b)
+#define CHIP8_TELEMETRY_JOIN2(a, b) a##b
+
+/**
+ * @return Nanoseconds since the telemetry epoch, taken the first time any timer runs.
+ */
+uint64_t telemetryNow();
+
+/**
+ * Appends a finished event to the calling thread's buffer. Never blocks: each thread owns its buffer,
+ * which keeps the most recent TELEMETRY_EVENTS_PER_THREAD events and overwrites the oldest.
+ */
+void recordTelemetryEvent(const char* name, uint64_t start, uint64_t end);
+
+static const size_t TELEMETRY_EVENTS_PER_THREAD = 1u << 16;
+
+class TelemetryScope {
+public:
+    explicit TelemetryScope(const char* name) : m_Name(name), m_Start(telemetryNow()) {}
+    ~TelemetryScope() { recordTelemetryEvent(m_Name, m_Start, telemetryNow()); }
+
+    TelemetryScope(const TelemetryScope&) = delete;
+    TelemetryScope& operator=(const TelemetryScope&) = delete;
+
+private:
+    const char* m_Name;
+    uint64_t m_Start;
+};
+
+struct TelemetryPhaseSummary {
+    const char* m_Name;
+    uint64_t m_Count;
+    double m_P50Micros;
+    double m_P95Micros;
+    double m_P99Micros;
+    double m_MaxMicros;
+};
+
+/**
+ * Percentiles per phase over the events still held in the buffers, i.e. the recent past of every thread.
+ * Safe to call while other threads keep recording.
+ * @param recentPerThread Only the most recent this many events of each thread are looked at, which bounds
+ *        the copy and the sort for callers on a frame loop.
+ * @return One entry per phase name, sorted by name.
+ */
+std::vector<TelemetryPhaseSummary> telemetrySummary(size_t recentPerThread = TELEMETRY_EVENTS_PER_THREAD);
+
+/**
+ * Prints telemetrySummary(recentPerThread) as a table.
+ */
+void printTelemetrySummary(FILE* out, size_t recentPerThread = TELEMETRY_EVENTS_PER_THREAD);
+
+/**
+ * Writes the buffered events as Chrome trace_event JSON ("X" complete events, one tid per buffer), which
+ * chrome://tracing and Perfetto load directly.
+ * @return false if the file could not be written.
+ */
+bool writeTelemetryTrace(const char* path);
+
+#else
+
+#define CHIP8_PROFILE_SCOPE(name) ((void)0)
+
+#endif // CHIP8_TELEMETRY
+
+
+#endif //MY_CHIP_8_EMULATOR_TELEMETRY_H
@@ -0,0 +1,199 @@
+//
+// ANSI terminal presentation and input for a CHIP8Context.
+//
+#include "TerminalDisplay.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#include <errno.h>
+#include <unistd.h>
+
+namespace {
+    // UTF-8 for the four cells: no pixel, top pixel (U+2580), bottom pixel (U+2584), both (U+2588).
+    const char* const GLYPHS[4] = {" ", "\xE2\x96\x80", "\xE2\x96\x84", "\xE2\x96\x88"};
+    const size_t GLYPH_BYTES[4] = {1, 3, 3, 3};
+
+    void writeAll(const char* data, size_t size) {
+        while (size > 0) {
+            const ssize_t written = ::write(STDOUT_FILENO, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+}
+
+const int TerminalDisplay::COLUMNS;
+const int TerminalDisplay::ROWS;
+const int TerminalDisplay::ESCAPE_WAIT_POLLS;
+
+TerminalDisplay::TerminalDisplay() {
+    std::memset(m_KeyForChar, -1, sizeof(m_KeyForChar));
+    std::memset(m_HeldFor, 0, sizeof(m_HeldFor));
+    std::memset(m_Cells, 0, sizeof(m_Cells));
+
+    // The same layout as the SDL frontend: 1234/QWER/ASDF/ZXCV onto 123C/456D/789E/A0BF.
+    const char* layout = "x123qweasdzc4rfv";
+    for (int key = 0; key < 16; ++key) {
+        m_KeyForChar[static_cast<unsigned char>(layout[key])] = static_cast<int8_t>(key);
+        m_KeyForChar[std::toupper(static_cast<unsigned char>(layout[key]))] = static_cast<int8_t>(key);
+    }
+    m_Output.reserve(ROWS * COLUMNS * 4);
+}
+
+TerminalDisplay::~TerminalDisplay() {
+    close();
+}
+
+bool TerminalDisplay::open() {
+    if (m_Open) {
+        return true;
+    }
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &m_SavedTermios) != 0) {
+        return false;
+    }
+
+    // No echo, no line buffering, no signals (Ctrl-C is read as a key), and reads that never block.
+    termios raw = m_SavedTermios;
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0) {
+        return false;
+    }
+    m_Open = true;
+    m_Escape = EscapeState::NONE;
+
+    // Alternate screen, hidden cursor, cleared: the terminal now shows all-blank cells.
+    static const char enter[] = "\x1b[?1049h\x1b[?25l\x1b[H\x1b[2J";
+    writeAll(enter, sizeof(enter) - 1);
+    std::memset(m_Cells, 0, sizeof(m_Cells));
+    m_CellsValid = true;
+    return true;
+}
+
+void TerminalDisplay::close() {
+    if (!m_Open) {
+        return;
+    }
+    static const char leave[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+    writeAll(leave, sizeof(leave) - 1);
+    tcsetattr(STDIN_FILENO, TCSANOW, &m_SavedTermios);
+    m_Open = false;
+}
+
+size_t TerminalDisplay::render(const CHIP8Context& chip8) {
+    m_Output.clear();
+    if (!m_CellsValid) {
+        m_Output += "\x1b[H\x1b[2J";
+        std::memset(m_Cells, 0, sizeof(m_Cells));
+        m_CellsValid = true;
+    }
+
+    char move[16];
+    for (int row = 0; row < ROWS; ++row) {
+        int cursor = -1; // column the cursor is at on this row, -1 if elsewhere
+        for (int column = 0; column < COLUMNS; ++column) {
+            const uint8_t cell = static_cast<uint8_t>((chip8.m_ScreenData[column][row * 2] ? 1 : 0) |
+                                                      (chip8.m_ScreenData[column][row * 2 + 1] ? 2 : 0));
+            if (cell == m_Cells[row][column]) {
+                continue;
+            }
+
+            if (cursor != column) {
+                // Either reprint the unchanged cells in between or jump over them, whichever is shorter.
+                const int length = cursor >= 0
+                    ? std::snprintf(move, sizeof(move), "\x1b[%dC", column - cursor)
+                    : std::snprintf(move, sizeof(move), "\x1b[%d;%dH", row + 1, column + 1);
+                size_t gapBytes = 0;
+                if (cursor >= 0) {
+                    for (int gap = cursor; gap < column; ++gap) {
+                        gapBytes += GLYPH_BYTES[m_Cells[row][gap]];
+                    }
+                }
+                if (cursor >= 0 && gapBytes <= static_cast<size_t>(length)) {
+                    for (int gap = cursor; gap < column; ++gap) {
+                        m_Output += GLYPHS[m_Cells[row][gap]];
+                    }
+                } else {
+                    m_Output.append(move, static_cast<size_t>(length));
+                }
+            }
+
+            m_Output += GLYPHS[cell];
+            m_Cells[row][column] = cell;
+            // Writing the last column leaves the cursor in the terminal's pending-wrap state; don't rely on it.
+            cursor = column + 1 < COLUMNS ? column + 1 : -1;
+        }
+    }
+
+    writeAll(m_Output.data(), m_Output.size());
+    return m_Output.size();
+}
+
+void TerminalDisplay::status(const char* text) {
+    char line[160];
+    const int length = std::snprintf(line, sizeof(line), "\x1b[%d;1H%s\x1b[K", ROWS + 2, text);
+    if (length > 0) {
+        writeAll(line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+    }
+}
+
+uint16_t TerminalDisplay::pollKeys(bool& quit) {
+    for (int& held : m_HeldFor) {
+        if (held > 0) {
+            --held;
+        }
+    }
+
+    // Escape sequences (arrow and function keys) are skipped. One may be split across reads, e.g. over
+    // SSH, so the parse state carries over between calls, and a lone Escape quits only once another key
+    // follows it or ESCAPE_WAIT_POLLS calls pass without the rest of a sequence.
+    unsigned char input[64];
+    ssize_t count;
+    while ((count = ::read(STDIN_FILENO, input, sizeof(input))) > 0) {
+        for (ssize_t i = 0; i < count; ++i) {
+            const unsigned char c = input[i];
+            if (c == 0x03) {
+                quit = true;
+            } else if (m_Escape == EscapeState::SEQUENCE) {
+                if (c >= 0x40 && c <= 0x7E) {
+                    m_Escape = EscapeState::NONE; // the final byte
+                }
+            } else if (m_Escape == EscapeState::ESCAPE) {
+                if (c == '[' || c == 'O') {
+                    m_Escape = EscapeState::SEQUENCE;
+                } else {
+                    m_Escape = EscapeState::NONE;
+                    quit = true;
+                }
+            } else if (c == 0x1b) {
+                m_Escape = EscapeState::ESCAPE;
+                m_EscapePolls = 0;
+            } else if (c < 128 && m_KeyForChar[c] >= 0) {
+                m_HeldFor[m_KeyForChar[c]] = m_HoldFrames;
+            }
+        }
+    }
+    if (m_Escape == EscapeState::ESCAPE && ++m_EscapePolls > ESCAPE_WAIT_POLLS) {
+        m_Escape = EscapeState::NONE;
+        quit = true;
+    }
+
+    uint16_t keys = 0;
+    for (int key = 0; key < 16; ++key) {
+        if (m_HeldFor[key] > 0) {
+            keys = static_cast<uint16_t>(keys | (1u << key));
+        }
+    }
+    return keys;
+}
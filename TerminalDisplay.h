@@ -0,0 +1,85 @@
+//
+// ANSI terminal presentation and input for a CHIP8Context, for hosts without a display: draws the screen
+// with Unicode half blocks and sends only the cells that changed. POSIX terminals only.
+//
+
+#ifndef MY_CHIP_8_EMULATOR_TERMINALDISPLAY_H
+#define MY_CHIP_8_EMULATOR_TERMINALDISPLAY_H
+
+#include "CHIP8.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <termios.h>
+
+/**
+ * Owns the terminal while open: raw non-blocking stdin, the alternate screen and a hidden cursor.
+ *
+ * The 64x32 screen maps onto 64x16 character cells, each showing two pixels stacked as one of
+ * ' ', U+2580, U+2584 or U+2588. Each frame is written with a single write(): only changed cells,
+ * a cursor move only where a run of changes is broken, and unchanged cells rewritten instead when
+ * that is shorter than the move.
+ */
+class TerminalDisplay {
+public:
+    static const int COLUMNS = 64;
+    static const int ROWS = 16;
+    static const int ESCAPE_WAIT_POLLS = 3; // polls a lone Escape waits for the rest of a split sequence
+
+    TerminalDisplay();
+    ~TerminalDisplay();
+
+    TerminalDisplay(const TerminalDisplay&) = delete;
+    TerminalDisplay& operator=(const TerminalDisplay&) = delete;
+
+    /**
+     * Switches stdin to raw mode and clears the screen.
+     * @return false if stdin is not a terminal.
+     */
+    bool open();
+
+    /**
+     * Restores the terminal as it was before open(). Also done by the destructor.
+     */
+    void close();
+
+    /**
+     * Draws the screen, sending only the cells that differ from the last frame drawn.
+     * @param chip8 The machine whose screen is drawn.
+     * @return The number of bytes written.
+     */
+    size_t render(const CHIP8Context& chip8);
+
+    /**
+     * Writes a line of text below the screen.
+     */
+    void status(const char* text);
+
+    /**
+     * Reads pending keystrokes. Terminals report presses but never releases, so a key counts as held
+     * until m_HoldFrames calls pass without it; the terminal's auto-repeat keeps a held key alive.
+     * @param quit Set to true on Ctrl-C, or on Escape once it is clearly not the start of a sequence.
+     * @return The keypad keys held, bit N for key N.
+     */
+    uint16_t pollKeys(bool& quit);
+
+    int m_HoldFrames = 10; // frames a key stays held after its last keystroke; cover the auto-repeat delay
+
+private:
+    enum class EscapeState : uint8_t { NONE, ESCAPE, SEQUENCE }; // where pollKeys is in an escape sequence
+
+    bool m_Open = false;
+    termios m_SavedTermios;
+    int8_t m_KeyForChar[128];   // keypad key per ASCII character, -1 if unmapped
+    int m_HeldFor[16];          // frames each key remains held
+    EscapeState m_Escape = EscapeState::NONE;
+    int m_EscapePolls = 0;      // polls since a lone Escape with nothing after it
+    uint8_t m_Cells[ROWS][COLUMNS]; // what the terminal shows: bit 0 top pixel, bit 1 bottom pixel
+    bool m_CellsValid = false;  // false until a full frame has been drawn
+    std::string m_Output;       // reused frame buffer
+};
+
+
+#endif //MY_CHIP_8_EMULATOR_TERMINALDISPLAY_H
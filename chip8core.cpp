@@ -0,0 +1,70 @@
+//
+// C interface to the CHIP-8 core. See chip8core.h.
+//
+#include "chip8core.h"
+#include "CHIP8.h"
+#include "CHIP8BootImage.h"
+
+#include <new>
+
+struct chip8_t {
+    CHIP8Context context;
+    CHIP8BootImage image;
+    uint32_t seed;
+};
+
+chip8_t* chip8_create(void) {
+    chip8_t* chip8 = new (std::nothrow) chip8_t();
+    if (!chip8) {
+        return nullptr;
+    }
+
+    chip8->seed = 0;
+    chip8_reset(chip8);
+    return chip8;
+}
+
+void chip8_destroy(chip8_t* chip8) {
+    delete chip8;
+}
+
+void chip8_reset(chip8_t* chip8) {
+    chip8->image.boot(chip8->context, chip8->seed);
+}
+
+size_t chip8_load_rom(chip8_t* chip8, const uint8_t* data, size_t size) {
+    const size_t loaded = chip8->image.loadROM(data, size);
+    chip8_reset(chip8);
+    return loaded;
+}
+
+int chip8_load_rom_file(chip8_t* chip8, const char* path) {
+    const bool loaded = chip8->image.loadFile(path);
+    chip8_reset(chip8);
+    return loaded ? 1 : 0;
+}
+
+void chip8_seed(chip8_t* chip8, uint32_t seed) {
+    chip8->seed = seed;
+    chip8->context.seedRandom(seed);
+}
+
+void chip8_run_cycles(chip8_t* chip8, int count) {
+    chip8->context.runCycles(count);
+}
+
+void chip8_set_keys(chip8_t* chip8, uint16_t keys) {
+    chip8->context.m_Keypad = keys;
+}
+
+void chip8_read_framebuffer(const chip8_t* chip8, uint8_t* out) {
+    for (int y = 0; y < CHIP8_SCREEN_HEIGHT; ++y) {
+        for (int x = 0; x < CHIP8_SCREEN_WIDTH; ++x) {
+            *out++ = chip8->context.m_ScreenData[x][y];
+        }
+    }
+}
+
+int chip8_sound_active(const chip8_t* chip8) {
+    return chip8->context.m_SoundTimer > 0;
+}
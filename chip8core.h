@@ -0,0 +1,73 @@
+/*
+ * C interface to the CHIP-8 core for embedding from C, Python (ctypes/cffi), Go (cgo) and others.
+ * Nothing here depends on SDL, and only chip8_create allocates.
+ */
+
+#ifndef MY_CHIP_8_EMULATOR_CHIP8CORE_H
+#define MY_CHIP_8_EMULATOR_CHIP8CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(CHIP8_SHARED)
+#  ifdef CHIP8_BUILDING_CORE
+#    define CHIP8_API __declspec(dllexport)
+#  else
+#    define CHIP8_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define CHIP8_API __attribute__((visibility("default")))
+#else
+#  define CHIP8_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHIP8_SCREEN_WIDTH  64
+#define CHIP8_SCREEN_HEIGHT 32
+
+typedef struct chip8_t chip8_t;
+
+/** Allocates a machine with no ROM loaded. Returns NULL if out of memory. */
+CHIP8_API chip8_t* chip8_create(void);
+
+/** Frees a machine created by chip8_create. Passing NULL is allowed. */
+CHIP8_API void chip8_destroy(chip8_t* chip8);
+
+/** Resets the machine to its boot image: cleared state, the font, and the last ROM loaded. A single copy. */
+CHIP8_API void chip8_reset(chip8_t* chip8);
+
+/**
+ * Copies a ROM into the machine and resets it. The caller's buffer is not retained.
+ * Returns the number of bytes loaded; ROMs larger than 0xE00 bytes are truncated.
+ */
+CHIP8_API size_t chip8_load_rom(chip8_t* chip8, const uint8_t* data, size_t size);
+
+/** Loads a ROM file and resets the machine. Returns 0 if the file could not be read, is empty or is larger than 0xE00 bytes. */
+CHIP8_API int chip8_load_rom_file(chip8_t* chip8, const char* path);
+
+/** Seeds the random number generator used by CXNN, making runs reproducible. */
+CHIP8_API void chip8_seed(chip8_t* chip8, uint32_t seed);
+
+/** Executes count instructions, ticking the timers after each one like the SDL frontend. */
+CHIP8_API void chip8_run_cycles(chip8_t* chip8, int count);
+
+/** Sets the held keys. Bit N set means keypad key N (0x0..0xF) is held. */
+CHIP8_API void chip8_set_keys(chip8_t* chip8, uint16_t keys);
+
+/**
+ * Copies the screen into out, which must hold CHIP8_SCREEN_WIDTH * CHIP8_SCREEN_HEIGHT bytes.
+ * Pixels are row-major, one byte each, 1 for lit and 0 for dark.
+ */
+CHIP8_API void chip8_read_framebuffer(const chip8_t* chip8, uint8_t* out);
+
+/** Returns non-zero while the sound timer is running. */
+CHIP8_API int chip8_sound_active(const chip8_t* chip8);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MY_CHIP_8_EMULATOR_CHIP8CORE_H */
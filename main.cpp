@@ -3,8 +3,110 @@
 //
 
 #include "CHIP8.h"
+#include "CHIP8BootImage.h"
+#include "CHIP8Trace.h"
+#include "RunAhead.h"
+#include "SDLFrontend.h"
+#include "Telemetry.h"
+#ifdef CHIP8_NETPLAY
+#include "Netplay.h"
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
 
 int main(int argc, char* argv[]) {
+    KeyMap keyMap = defaultKeyMap();
+    int runAheadFrames = 0;
+    bool turbo = false;
+    double turboMultiplier = 0.0; // 0 runs unthrottled
+    int turboFrameSkip = 0;       // render every Kth frame while fast-forwarding; 0 renders at most 60 times a second
+    const char* tracePath = nullptr;
+    bool predecode = false;
+    const char* romPath = "Pong.ch8";
+    bool netplayEnabled = false;
+#ifdef CHIP8_NETPLAY
+    NetplayConfig netplayConfig;
+#endif
+#ifdef CHIP8_TELEMETRY
+    const char* telemetryPath = nullptr;
+#endif
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--keymap") == 0 && i + 1 < argc) {
+            if (!parseKeyMap(argv[++i], keyMap)) {
+                std::cerr << "Invalid key map: expected 16 comma separated SDL key names for keys 0..F\n";
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc) {
+            runAheadFrames = std::atoi(argv[++i]);
+            if (runAheadFrames < 0) {
+                std::cerr << "Run-ahead frame count must be 0 or more\n";
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--turbo") == 0 && i + 1 < argc) {
+            turbo = true;
+            turboMultiplier = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frameskip") == 0 && i + 1 < argc) {
+            turboFrameSkip = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--predecode") == 0) {
+            predecode = true;
+#ifdef CHIP8_TELEMETRY
+        } else if (std::strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            telemetryPath = argv[++i];
+#endif
+#ifdef CHIP8_NETPLAY
+        } else if (std::strcmp(argv[i], "--netplay") == 0 && i + 4 < argc) {
+            netplayEnabled = true;
+            netplayConfig.m_LocalPlayer = std::atoi(argv[++i]);
+            netplayConfig.m_LocalPort = static_cast<uint16_t>(std::atoi(argv[++i]));
+            netplayConfig.m_RemoteHost = argv[++i];
+            netplayConfig.m_RemotePort = static_cast<uint16_t>(std::atoi(argv[++i]));
+#endif
+        } else if (argv[i][0] != '-') {
+            romPath = argv[i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [ROM] [--keymap X,1,2,3,Q,W,E,A,S,D,Z,C,4,R,F,V] [--run-ahead FRAMES]"
+                      << " [--turbo MULTIPLIER (0 = unthrottled)] [--frameskip K] [--trace FILE] [--predecode]"
+                      << " [--telemetry FILE]"
+                      << " [--netplay PLAYER LOCAL_PORT REMOTE_HOST REMOTE_PORT]\n";
+            return 1;
+        }
+    }
+
+    if (turbo && netplayEnabled) {
+        // Netplay paces frames for the peer; running ahead of it would only stall the session.
+        std::cerr << "--turbo cannot be combined with --netplay\n";
+        return 1;
+    }
+    if (tracePath && netplayEnabled) {
+        // Rollback re-simulates frames inside the session, where the recorder cannot follow.
+        std::cerr << "--trace cannot be combined with --netplay\n";
+        return 1;
+    }
+    if (runAheadFrames > 0 && (turbo || netplayEnabled)) {
+        // Fast-forward shows frames it already skipped past, and netplay's rollback already predicts input.
+        std::cerr << "--run-ahead cannot be combined with " << (turbo ? "--turbo" : "--netplay") << "\n";
+        return 1;
+    }
+
+    // The ROM is read once; every reset after this is a copy of the boot image.
+    CHIP8BootImage bootImage;
+    if (!bootImage.loadFile(romPath)) {
+        std::cerr << "Could not load ROM " << romPath << "\n";
+        return 1;
+    }
+    if (predecode) {
+        bootImage.predecode();
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << "\n";
@@ -25,51 +127,214 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Create renderer
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    // Create renderer. No vsync: the frame loop paces presents itself, and a present that waited for vblank
+    // would cap fast-forward at the display's refresh rate.
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
     CHIP8Context chip8;
-    chip8.CPUReset();
+    chip8.CPUReset(bootImage);
+
+#ifdef CHIP8_NETPLAY
+    // Both peers must run identical machines, so the random seed is fixed rather than drawn per reset.
+    NetplaySession netplay;
+    uint16_t netplayKeys = 0;
+    if (netplayEnabled) {
+        chip8.seedRandom(0xC8C8C8C8u);
+        if (!netplay.open(netplayConfig)) {
+            return 1;
+        }
+    }
+#endif
 
     bool running = true;
-    SDL_Event e;
+    std::vector<CHIP8KeyEvent> keyEvents;
+    keyEvents.reserve(64);
 
     const int INSTRUCTIONS_PER_SECOND = 900; // Can be adjusted to be between 500-1000
     const int INSTRUCTIONS_PER_FRAME = INSTRUCTIONS_PER_SECOND / 60;
 
-    auto lastTime = std::chrono::high_resolution_clock::now();
+    RunAhead runAhead(runAheadFrames, INSTRUCTIONS_PER_FRAME);
+    int framesSinceReport = 0;
+
+    // Tracing records every instruction of the real machine; speculative run-ahead frames are not traced.
+    TraceRecorder tracer;
+    if (tracePath && !tracer.open(tracePath)) {
+        return 1;
+    }
+    auto runFrame = [&](const CHIP8KeyEvent* events, size_t eventCount) {
+        if (tracePath) {
+            tracer.runCycles(chip8, INSTRUCTIONS_PER_FRAME, events, eventCount);
+        } else if (bootImage.blockMap()) {
+            chip8.runCyclesPredecoded(*bootImage.blockMap(), INSTRUCTIONS_PER_FRAME, events, eventCount);
+        } else {
+            chip8.runCycles(INSTRUCTIONS_PER_FRAME, events, eventCount);
+        }
+    };
+
+    using Clock = std::chrono::high_resolution_clock;
+    auto secondsSince = [](Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    // Fast-forward bookkeeping
+    auto turboStart = Clock::now();
+    uint64_t turboFrames = 0;
+    int framesSinceRender = 0;
+    auto lastRender = Clock::now();
+
+    // Emulated speed, reported once a second
+    auto speedWindowStart = Clock::now();
+    uint64_t speedFrames = 0;
+
+#ifdef CHIP8_TELEMETRY
+    auto telemetryReportStart = Clock::now();
+#endif
+
+    auto lastTime = Clock::now();
+    Uint32 inputWindowStart = SDL_GetTicks();
 
     while (running) {
-        auto currentTime = std::chrono::high_resolution_clock::now();
+        auto currentTime = Clock::now();
         double elapsedMs = std::chrono::duration<double, std::milli>(currentTime - lastTime).count();
 
-        if (elapsedMs >= (1000.0 / 60.0)) { // 60Hz tick
+        if (turbo || elapsedMs >= (1000.0 / 60.0)) { // 60Hz tick, or as often as possible when fast-forwarding
             lastTime = currentTime;
+            CHIP8_PROFILE_SCOPE("frame");
 
-            // Handle input events once per frame
-            chip8.processInput(chip8, e, running);
+            // Collect the key events of the frame that just ended and replay them at matching cycles
+            const Uint32 inputWindowEnd = SDL_GetTicks();
+            bool toggleTurbo = false;
+            {
+                CHIP8_PROFILE_SCOPE("input");
+                processInput(keyMap, inputWindowStart, inputWindowEnd, INSTRUCTIONS_PER_FRAME, keyEvents, toggleTurbo, running);
+            }
+            inputWindowStart = inputWindowEnd;
 
-            // Run one CPU cycle
-            for (int i = 0; i < INSTRUCTIONS_PER_FRAME; i++) {
-                chip8.execute();
+            if (toggleTurbo && !netplayEnabled && runAheadFrames == 0) {
+                turbo = !turbo;
+                turboStart = Clock::now();
+                turboFrames = 0;
+            }
 
-                if (chip8.m_DelayTimer > 0) {
-                    chip8.m_DelayTimer--;
-                }
+            const CHIP8Context* display = &chip8;
+            bool present = true;
+            bool idle = false; // fast-forwarding with a multiplier and no frame due yet
+
+            {
+                CHIP8_PROFILE_SCOPE("execute");
+                if (netplayEnabled) {
+#ifdef CHIP8_NETPLAY
+                    // Netplay exchanges one keypad state per frame: the keys held at the end of the frame.
+                    for (const CHIP8KeyEvent& event : keyEvents) {
+                        const uint16_t bit = static_cast<uint16_t>(1u << event.key);
+                        netplayKeys = event.pressed ? (netplayKeys | bit) : (netplayKeys & ~bit);
+                    }
+                    if (netplay.advanceFrame(chip8, netplayKeys)) {
+                        ++speedFrames;
+                    }
+#endif
+                } else if (turbo) {
+                    // Run the frames the multiplier allows, or as many as fit in one host frame when unthrottled.
+                    // Key events belong to the first frame of the batch.
+                    int64_t due = turboMultiplier > 0.0
+                        ? static_cast<int64_t>(secondsSince(turboStart) * 60.0 * turboMultiplier) - static_cast<int64_t>(turboFrames)
+                        : INT64_MAX;
+                    idle = due <= 0;
+                    const auto batchStart = Clock::now();
+                    const CHIP8KeyEvent* events = keyEvents.data();
+                    size_t eventCount = keyEvents.size();
+
+                    while (due-- > 0) {
+                        runFrame(events, eventCount);
+                        events = nullptr;
+                        eventCount = 0;
+                        ++turboFrames;
+                        ++speedFrames;
+                        ++framesSinceRender;
 
-                if (chip8.m_SoundTimer > 0) {
-                    chip8.m_SoundTimer--;
-                    if (chip8.m_SoundTimer == 0) {
-                        // TODO: Stop Sound.
+                        if (turboFrameSkip > 0 ? framesSinceRender >= turboFrameSkip
+                                               : secondsSince(batchStart) >= 1.0 / 60.0) {
+                            break;
+                        }
                     }
+                    for (size_t i = 0; i < eventCount; ++i) {
+                        chip8.applyKeyEvent(events[i]);
+                    }
+
+                    // Present at most once per host frame, and with a frame skip only after K new frames.
+                    present = framesSinceRender > 0 && framesSinceRender >= turboFrameSkip
+                           && secondsSince(lastRender) >= 1.0 / 60.0;
+                } else {
+                    // Run one frame's worth of CPU cycles (traced if asked), plus any run-ahead frames for display
+                    runFrame(keyEvents.data(), keyEvents.size());
+                    display = &runAhead.lookAhead(chip8);
+                    ++speedFrames;
+                }
+            }
+
+            if (runAheadFrames > 0 && ++framesSinceReport == 300) {
+                framesSinceReport = 0;
+                std::cout << "Run-ahead " << runAheadFrames << " frame(s): "
+                          << runAhead.m_AverageOverheadMicros << " us/frame overhead\n";
+            }
+
+            const double speedSeconds = secondsSince(speedWindowStart);
+            if (speedSeconds >= 1.0) {
+                const double framesPerSecond = speedFrames / speedSeconds;
+                const double mips = framesPerSecond * INSTRUCTIONS_PER_FRAME / 1e6;
+                const double realTime = framesPerSecond / 60.0;
+
+                char title[96];
+                std::snprintf(title, sizeof(title), "CHIP-8 Emulator - %.3f MIPS (%.1fx)%s",
+                              mips, realTime, turbo ? " [turbo]" : "");
+                SDL_SetWindowTitle(window, title);
+                if (turbo) {
+                    std::cout << "Speed: " << mips << " MIPS, " << realTime << "x real time\n";
+                }
+
+                speedWindowStart = Clock::now();
+                speedFrames = 0;
+            }
+
+#ifdef CHIP8_TELEMETRY
+            // A rolling view of where frame time goes; the full timeline is written on exit. This runs on the
+            // frame loop, so it summarizes only about the last five seconds at 60 fps (eight phases a frame)
+            // rather than copying and sorting every buffered event.
+            if (telemetryPath && secondsSince(telemetryReportStart) >= 5.0) {
+                printTelemetrySummary(stdout, 4096);
+                telemetryReportStart = Clock::now();
+            }
+#endif
+
+            if (present) {
+                {
+                    CHIP8_PROFILE_SCOPE("render");
+                    render(*display, renderer);
                 }
+                {
+                    CHIP8_PROFILE_SCOPE("present");
+                    SDL_RenderPresent(renderer);
+                }
+                framesSinceRender = 0;
+                lastRender = Clock::now();
+            }
+
+            if (!turbo || idle) {
+                // SDL_Delay(16); (Delay to simulate ~60Hz)
+                CHIP8_PROFILE_SCOPE("idle");
+                SDL_Delay(1);
             }
-            chip8.render(renderer);
-            // SDL_Delay(16); (Delay to simulate ~60Hz)
-            SDL_Delay(1);
         }
     }
 
+    tracer.close();
+#ifdef CHIP8_TELEMETRY
+    if (telemetryPath) {
+        printTelemetrySummary(stdout);
+        writeTelemetryTrace(telemetryPath);
+    }
+#endif
+
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
@@ -0,0 +1,129 @@
+//
+// Static analysis of a ROM: prints a summary of its blocks, functions and findings, and optionally writes
+// the control-flow graph as Graphviz DOT and the full analysis as JSON.
+//
+// Usage: chip8-analyze ROM [--dot FILE] [--json FILE] [--list]
+//
+// FILE may be "-" for standard output.
+//
+
+#include "CHIP8Analyzer.h"
+#include "CHIP8BootImage.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    bool writeTo(const char* path, const CHIP8Analysis& analysis, void (*writer)(const CHIP8Analysis&, FILE*)) {
+        if (std::strcmp(path, "-") == 0) {
+            writer(analysis, stdout);
+            return true;
+        }
+
+        FILE* out = std::fopen(path, "w");
+        if (!out) {
+            perror(path);
+            return false;
+        }
+        writer(analysis, out);
+        std::fclose(out);
+        return true;
+    }
+
+    void printListing(const CHIP8Analysis& analysis) {
+        char text[32];
+        for (const CHIP8BasicBlock& block : analysis.m_Blocks) {
+            std::printf("%03X:\n", block.m_Start);
+            for (uint16_t address = block.m_Start; address < block.m_End; address = static_cast<uint16_t>(address + 2)) {
+                const uint16_t opcode = analysis.opcodeAt(address);
+                formatInstruction(opcode, text, sizeof(text));
+                std::printf("    %03X  %04X  %s\n", address & 0x0FFF, opcode, text);
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* romPath = nullptr;
+    const char* dotPath = nullptr;
+    const char* jsonPath = nullptr;
+    bool listing = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--dot") == 0 && i + 1 < argc) {
+            dotPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--list") == 0) {
+            listing = true;
+        } else if (!romPath && argv[i][0] != '-') {
+            romPath = argv[i];
+        } else {
+            romPath = nullptr;
+            break;
+        }
+    }
+
+    if (!romPath) {
+        std::fprintf(stderr, "Usage: %s ROM [--dot FILE] [--json FILE] [--list]\n", argv[0]);
+        return 2;
+    }
+
+    CHIP8BootImage image;
+    if (!image.loadFile(romPath)) {
+        return 1;
+    }
+    const CHIP8Analysis analysis = analyzeMemory(image.image().m_GameMemory, image.romSize());
+
+    if ((dotPath && !writeTo(dotPath, analysis, writeAnalysisDot)) ||
+        (jsonPath && !writeTo(jsonPath, analysis, writeAnalysisJson))) {
+        return 1;
+    }
+    // Keep standard output clean for whichever format was sent there.
+    if ((dotPath && std::strcmp(dotPath, "-") == 0) || (jsonPath && std::strcmp(jsonPath, "-") == 0)) {
+        return 0;
+    }
+
+    if (listing) {
+        printListing(analysis);
+    }
+
+    size_t codeBytes = 0;
+    for (int address = analysis.m_RomStart; address < analysis.m_RomEnd; ++address) {
+        codeBytes += (analysis.m_Flags[address] & CHIP8Analysis::CODE_BYTE) != 0;
+    }
+    std::printf("%s: %zu bytes, %zu reachable as code, %zu blocks, %zu functions\n", romPath, image.romSize(),
+                codeBytes, analysis.m_Blocks.size(), analysis.m_Functions.size());
+
+    for (const CHIP8Function& function : analysis.m_Functions) {
+        std::printf("  function %03X: %zu blocks, calls", function.m_Entry, function.m_Blocks.size());
+        if (function.m_Callees.empty()) {
+            std::printf(" nothing");
+        }
+        for (uint16_t callee : function.m_Callees) {
+            std::printf(" %03X", callee);
+        }
+        std::printf("\n");
+    }
+
+    char text[32];
+    for (const CHIP8Finding& finding : analysis.m_Findings) {
+        std::printf("  %-20s %03X", findingName(finding.m_Kind), finding.m_Address);
+        switch (finding.m_Kind) {
+            case CHIP8FindingKind::DATA_REGION:
+            case CHIP8FindingKind::UNREACHABLE_CODE:
+                std::printf("..%03X (%d bytes)", finding.m_End - 1, finding.m_End - finding.m_Address);
+                break;
+            case CHIP8FindingKind::SELF_MODIFYING_WRITE:
+            case CHIP8FindingKind::OUTSIDE_ROM:
+                std::printf(" -> %03X", finding.m_Target);
+                break;
+            default:
+                formatInstruction(analysis.opcodeAt(finding.m_Address), text, sizeof(text));
+                std::printf("  %s", text);
+                break;
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
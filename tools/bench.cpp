@@ -0,0 +1,136 @@
+//
+// Measures aggregate throughput of the batched interpreter as the number of lanes grows, against the same
+// number of independent CHIP8Context machines run one after another.
+//
+// Usage: chip8-bench [rom.ch8] [seconds-per-size] [--inputs random|shared|lockstep]
+//
+// random:   every lane holds its own random key, the way lanes diverge under an RL policy (the default).
+// shared:   every lane holds the same key; lanes still drift apart through their own CXNN seeds.
+// lockstep: the same key and the same seed in every lane, so the lanes never diverge. This is the best
+//           case for batching, e.g. evaluating one policy on identical environments.
+//
+
+#include "CHIP8BootImage.h"
+#include "CHIP8Batch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+    enum class Inputs { RANDOM, SHARED, LOCKSTEP };
+
+    // Fills one key per lane for the next frame.
+    void nextKeys(Inputs inputs, uint32_t& random, std::vector<uint16_t>& keys) {
+        for (std::size_t lane = 0; lane < keys.size(); ++lane) {
+            if (lane == 0 || inputs == Inputs::RANDOM) {
+                random = random * 1664525u + 1013904223u;
+            }
+            keys[lane] = static_cast<uint16_t>(1u << (random >> 28));
+        }
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* romPath = "Pong.ch8";
+    double secondsPerSize = 1.0;
+    Inputs inputs = Inputs::RANDOM;
+    int positional = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--inputs") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "random") == 0) {
+                inputs = Inputs::RANDOM;
+            } else if (std::strcmp(mode, "shared") == 0) {
+                inputs = Inputs::SHARED;
+            } else if (std::strcmp(mode, "lockstep") == 0) {
+                inputs = Inputs::LOCKSTEP;
+            } else {
+                std::fprintf(stderr, "Unknown input mode: %s\n", mode);
+                return 1;
+            }
+        } else if (argv[i][0] != '-' && positional == 0) {
+            romPath = argv[i];
+            ++positional;
+        } else if (argv[i][0] != '-' && positional == 1) {
+            secondsPerSize = std::atof(argv[i]);
+            ++positional;
+        } else {
+            std::fprintf(stderr, "Usage: %s [rom.ch8] [seconds-per-size] [--inputs random|shared|lockstep]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    CHIP8BootImage image;
+    if (!image.loadFile(romPath)) {
+        return 1;
+    }
+
+    // How each lane instruction ran: in a uniform warp, in a group of a divergent warp, or on its own.
+    std::printf("%10s %16s %16s %16s %8s %9s %9s %9s\n",
+                "lanes", "steps/s", "instr/s", "scalar steps/s", "speedup", "uniform", "grouped", "single");
+
+    for (std::size_t lanes = 1; lanes <= 16384; lanes *= 4) {
+        std::vector<uint16_t> keys(lanes);
+
+        // Baseline: the same machines as independent contexts, each run for a frame in turn.
+        std::vector<CHIP8Context> machines(lanes);
+        CHIP8Batch batch(lanes);
+        batch.loadBootImage(image);
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            if (inputs == Inputs::LOCKSTEP) {
+                batch.m_RandomState[lane] = batch.m_RandomState[0];
+            }
+            image.boot(machines[lane], batch.m_RandomState[lane]);
+        }
+
+        uint32_t random = 0x12345678u;
+        uint64_t frames = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        while (elapsed < secondsPerSize) {
+            nextKeys(inputs, random, keys);
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                machines[lane].m_Keypad = keys[lane];
+                machines[lane].runCycles(CHIP8Batch::INSTRUCTIONS_PER_FRAME);
+            }
+            if ((++frames & 15) == 0) {
+                elapsed = secondsSince(start);
+            }
+        }
+        const double scalarSteps = static_cast<double>(frames) * lanes / elapsed;
+
+        std::vector<uint64_t> observations(lanes * CHIP8Batch::SCREEN_ROWS);
+        uint64_t grouped = 0, single = 0;
+        random = 0x12345678u;
+        frames = 0;
+        start = std::chrono::steady_clock::now();
+        elapsed = 0.0;
+        while (elapsed < secondsPerSize) {
+            nextKeys(inputs, random, keys);
+            batch.step(keys.data(), observations.data());
+            grouped += batch.m_GroupedLanes;
+            single += batch.m_SingleLanes;
+            if ((++frames & 15) == 0) {
+                elapsed = secondsSince(start);
+            }
+        }
+        const double steps = static_cast<double>(frames) * lanes / elapsed;
+        const double laneInstructions = static_cast<double>(frames) * lanes * CHIP8Batch::INSTRUCTIONS_PER_FRAME;
+
+        const double groupedShare = 100.0 * grouped / laneInstructions;
+        const double singleShare = 100.0 * single / laneInstructions;
+        std::printf("%10zu %16.0f %16.0f %16.0f %7.2fx %8.1f%% %8.1f%% %8.1f%%\n",
+                    lanes, steps, steps * CHIP8Batch::INSTRUCTIONS_PER_FRAME, scalarSteps, steps / scalarSteps,
+                    100.0 - groupedShare - singleShare, groupedShare, singleShare);
+    }
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+//
+// Self-check for CHIP8Debugger: runs small built-in ROMs under breakpoints and watchpoints, splitting each
+// continue into runs of different lengths the way chip8-gdbserver does, and checks every stop.
+//
+// Usage: chip8-debugger-check [ROM]
+//
+// With a ROM, also checks that running it under the debugger with nothing set matches plain runCycles.
+// Exits with 0 if every check passed and 1 otherwise.
+//
+
+#include "CHIP8BootImage.h"
+#include "CHIP8Debugger.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+    int g_Failures = 0;
+
+    void check(bool ok, const char* what, int chunk) {
+        if (!ok) {
+            std::printf("FAIL: %s (runs of %d)\n", what, chunk);
+            ++g_Failures;
+        }
+    }
+
+    void boot(CHIP8Context& chip8, const std::vector<uint16_t>& program) {
+        std::vector<uint8_t> rom;
+        for (uint16_t opcode : program) {
+            rom.push_back(static_cast<uint8_t>(opcode >> 8));
+            rom.push_back(static_cast<uint8_t>(opcode & 0xFF));
+        }
+        CHIP8BootImage image;
+        image.loadROM(rom.data(), rom.size());
+        image.boot(chip8, 1);
+    }
+
+    // Continues in runs of chunk instructions until something stops it or limit instructions have run.
+    CHIP8StopInfo resume(CHIP8Debugger& debugger, CHIP8Context& chip8, int chunk, int limit, int& executed) {
+        executed = 0;
+        while (executed < limit) {
+            const CHIP8StopInfo stop = debugger.run(chip8, chunk);
+            executed += stop.m_Executed;
+            if (stop.m_Reason != CHIP8StopReason::NONE) {
+                return stop;
+            }
+        }
+        return CHIP8StopInfo{CHIP8StopReason::NONE, static_cast<uint16_t>(chip8.m_ProgramCounter & 0x0FFF), executed};
+    }
+
+    // Counts V0 up to 0xFA, which first reaches 0x20A as instruction 1001, then spins at 0x20C.
+    const std::vector<uint16_t> COUNTER = {0x6000, 0x7001, 0x6100, 0x30FA, 0x1202, 0x00E0, 0x120C};
+
+    void checkBreakpoints(int chunk) {
+        CHIP8Context chip8;
+        boot(chip8, COUNTER);
+        CHIP8Debugger debugger;
+        debugger.setBreakpoint(0x20A, true);
+        debugger.setBreakpoint(0x20C, true);
+
+        int executed;
+        CHIP8StopInfo stop = resume(debugger, chip8, chunk, 5000, executed);
+        check(stop.m_Reason == CHIP8StopReason::BREAKPOINT && stop.m_Address == 0x20A && executed == 1000,
+              "breakpoint first reached at instruction 1001", chunk);
+
+        // Resuming runs the instruction stopped at, then stops at the next breakpoint.
+        stop = resume(debugger, chip8, chunk, 5000, executed);
+        check(stop.m_Reason == CHIP8StopReason::BREAKPOINT && stop.m_Address == 0x20C && executed == 1,
+              "resume from a breakpoint", chunk);
+
+        // 120C jumps to itself: each resume executes it once and stops at it again.
+        stop = resume(debugger, chip8, chunk, 5000, executed);
+        check(stop.m_Reason == CHIP8StopReason::BREAKPOINT && stop.m_Address == 0x20C && executed == 1,
+              "resume onto the same breakpoint", chunk);
+
+        // Moving PC after a stop means the new instruction has not been reported yet.
+        chip8.m_ProgramCounter = 0x20A;
+        stop = resume(debugger, chip8, chunk, 5000, executed);
+        check(stop.m_Reason == CHIP8StopReason::BREAKPOINT && stop.m_Address == 0x20A && executed == 0,
+              "breakpoint at a PC set by the client", chunk);
+    }
+
+    void checkWatchpoints(int chunk) {
+        // I=0x300; V0=5; wait 1000 instructions; FX55 stores V0; FX65 loads it; DXYN reads it; spin.
+        CHIP8Context chip8;
+        boot(chip8, {0xA300, 0x6005, 0x6100, 0x7101, 0x31F9, 0x1206, 0xF055, 0xF065, 0xD011, 0x1212});
+        CHIP8Debugger debugger;
+        debugger.setWatchpoint(0x300, 1, CHIP8Debugger::WATCH_WRITE, true);
+
+        int executed;
+        CHIP8StopInfo stop = resume(debugger, chip8, chunk, 5000, executed);
+        check(stop.m_Reason == CHIP8StopReason::WATCH_WRITE && stop.m_Address == 0x300 &&
+              chip8.m_ProgramCounter == 0x20C && chip8.m_GameMemory[0x300] == 0,
+              "write watchpoint stops before FX55", chunk);
+
+        debugger.setWatchpoint(0x300, 1, CHIP8Debugger::WATCH_WRITE, false);
+        debugger.setWatchpoint(0x300, 1, CHIP8Debugger::WATCH_READ, true);
+        stop = resume(debugger, chip8, chunk, 5000, executed);
+        check(stop.m_Reason == CHIP8StopReason::WATCH_READ && chip8.m_ProgramCounter == 0x20E &&
+              chip8.m_GameMemory[0x300] == 5 && executed == 1,
+              "read watchpoint stops before FX65", chunk);
+
+        stop = resume(debugger, chip8, chunk, 5000, executed);
+        check(stop.m_Reason == CHIP8StopReason::WATCH_READ && chip8.m_ProgramCounter == 0x210 && executed == 1,
+              "read watchpoint stops before DXYN", chunk);
+
+        stop = resume(debugger, chip8, chunk, 5000, executed);
+        check(stop.m_Reason == CHIP8StopReason::NONE, "no stop once past the last access", chunk);
+    }
+
+    // Running with nothing set must be indistinguishable from CHIP8Context::runCycles.
+    void checkTransparent(const CHIP8BootImage& image, int chunk) {
+        CHIP8Context reference;
+        CHIP8Context debugged;
+        image.boot(reference, 7);
+        image.boot(debugged, 7);
+        CHIP8Debugger debugger;
+
+        int executed;
+        resume(debugger, debugged, chunk, 100000, executed);
+        reference.runCycles(executed);
+        check(reference.stateHash() == debugged.stateHash(), "debugger with nothing set matches runCycles", chunk);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    CHIP8BootImage image;
+    if (argc > 1 && !image.loadFile(argv[1])) {
+        return 1;
+    }
+
+    const int chunks[] = {1, 7, 999, 1000, 1001, 100000};
+    for (int chunk : chunks) {
+        checkBreakpoints(chunk);
+        checkWatchpoints(chunk);
+        if (argc > 1) {
+            checkTransparent(image, chunk);
+        }
+    }
+
+    if (g_Failures) {
+        std::printf("%d check(s) failed\n", g_Failures);
+        return 1;
+    }
+    std::printf("OK: all debugger checks passed\n");
+    return 0;
+}
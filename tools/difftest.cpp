@@ -0,0 +1,202 @@
+//
+// Differential testing: runs the reference interpreter (CHIP8Context) and the batched engine (CHIP8Batch)
+// side by side on the same ROMs, seeds and key presses, compares state hashes after every instruction
+// (or every frame), and stops at the first divergence with a dump of both states.
+//
+// Usage: chip8-difftest [--frames N] [--lanes L] [--seed S] [--per-frame] [--predecode] ROM...
+//
+// --predecode runs the reference interpreter from a predecoded CHIP8BootImage, which checks the block map
+// against the batched engine's plain fetch and decode.
+//
+// Exits with 0 if every ROM matched, 1 on the first divergence and 2 on a usage or I/O error.
+//
+
+#include "CHIP8.h"
+#include "CHIP8Batch.h"
+#include "CHIP8BootImage.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+    struct Options {
+        int m_Frames = 3600;
+        std::size_t m_Lanes = 8;
+        uint32_t m_Seed = 0x2545F491u;
+        bool m_PerFrame = false;
+        bool m_Predecode = false;
+    };
+
+    // Key presses for one lane: holds a random key (or none) for a random number of frames.
+    struct InputScript {
+        uint32_t m_State;
+        uint16_t m_Keys = 0;
+        int m_FramesLeft = 0;
+
+        uint16_t next() {
+            if (m_FramesLeft-- <= 0) {
+                m_State = m_State * 1664525u + 1013904223u;
+                const uint32_t key = (m_State >> 20) % 18;
+                m_Keys = key < 16 ? static_cast<uint16_t>(1u << key) : 0;
+                m_FramesLeft = static_cast<int>((m_State >> 8) % 30);
+            }
+            return m_Keys;
+        }
+    };
+
+    void dumpState(const char* name, const CHIP8Context& c) {
+        std::printf("  %-9s PC=%04X I=%04X SP=%u DT=%02X ST=%02X keys=%04X rng=%08X\n           V:",
+                    name, c.m_ProgramCounter, c.m_AddressI, c.m_StackPointer, c.m_DelayTimer, c.m_SoundTimer,
+                    c.m_Keypad, c.m_RandomState);
+        for (int i = 0; i < 16; ++i) {
+            std::printf(" %02X", c.m_Registers[i]);
+        }
+        std::printf("\n           stack:");
+        for (int i = 0; i < c.m_StackPointer && i < 16; ++i) {
+            std::printf(" %03X", c.m_Stack[i]);
+        }
+        std::printf("\n");
+    }
+
+    void dumpDivergence(const CHIP8Context& reference, const CHIP8Context& candidate) {
+        dumpState("reference", reference);
+        dumpState("batch", candidate);
+
+        int shown = 0;
+        for (int address = 0; address < 0x1000; ++address) {
+            if (reference.m_GameMemory[address] != candidate.m_GameMemory[address] && shown++ < 16) {
+                std::printf("  memory[%03X]: reference %02X, batch %02X\n", address,
+                            reference.m_GameMemory[address], candidate.m_GameMemory[address]);
+            }
+        }
+
+        int pixels = 0;
+        for (int x = 0; x < 64; ++x) {
+            for (int y = 0; y < 32; ++y) {
+                pixels += reference.m_ScreenData[x][y] != candidate.m_ScreenData[x][y];
+            }
+        }
+        if (pixels) {
+            std::printf("  screen: %d pixels differ\n", pixels);
+        }
+    }
+
+    uint32_t laneSeed(uint32_t seed, std::size_t lane) {
+        // Same derivation as CHIP8Batch::resetLane.
+        return seed ^ static_cast<uint32_t>(lane * 0x9E3779B9u);
+    }
+
+    // Returns true if the engines agreed for the whole run.
+    bool runRom(const char* path, const std::vector<uint8_t>& rom, const Options& options) {
+        CHIP8Batch batch(options.m_Lanes, options.m_Seed);
+        batch.loadROM(rom.data(), rom.size());
+
+        CHIP8BootImage image;
+        if (options.m_Predecode) {
+            image.loadROM(rom.data(), rom.size());
+            image.predecode();
+        }
+
+        std::vector<CHIP8Context> references(options.m_Lanes);
+        std::vector<InputScript> scripts(options.m_Lanes);
+        for (std::size_t lane = 0; lane < options.m_Lanes; ++lane) {
+            if (options.m_Predecode) {
+                image.boot(references[lane], laneSeed(options.m_Seed, lane));
+            } else {
+                references[lane].resetState();
+                references[lane].seedRandom(laneSeed(options.m_Seed, lane));
+                references[lane].loadROM(rom.data(), rom.size());
+            }
+            scripts[lane].m_State = laneSeed(options.m_Seed, lane) | 1;
+        }
+
+        CHIP8Context candidate;
+        const int cyclesPerStep = options.m_PerFrame ? CHIP8Batch::INSTRUCTIONS_PER_FRAME : 1;
+        const int stepsPerFrame = CHIP8Batch::INSTRUCTIONS_PER_FRAME / cyclesPerStep;
+
+        for (int frame = 0; frame < options.m_Frames; ++frame) {
+            for (std::size_t lane = 0; lane < options.m_Lanes; ++lane) {
+                const uint16_t keys = scripts[lane].next();
+                batch.m_Keypad[lane] = keys;
+                references[lane].m_Keypad = keys;
+            }
+
+            for (int step = 0; step < stepsPerFrame; ++step) {
+                batch.runCycles(cyclesPerStep);
+
+                for (std::size_t lane = 0; lane < options.m_Lanes; ++lane) {
+                    CHIP8Context& reference = references[lane];
+                    const CHIP8Context::WORD pc = reference.m_ProgramCounter;
+                    const CHIP8Context::WORD opcode = static_cast<CHIP8Context::WORD>(
+                        (reference.m_GameMemory[pc & 0x0FFF] << 8) | reference.m_GameMemory[(pc + 1) & 0x0FFF]);
+                    if (options.m_Predecode) {
+                        reference.runCyclesPredecoded(*image.blockMap(), cyclesPerStep);
+                    } else {
+                        reference.runCycles(cyclesPerStep);
+                    }
+                    batch.copyLane(lane, candidate);
+
+                    if (candidate.stateHash() != reference.stateHash()) {
+                        std::printf("%s: DIVERGED in lane %zu at frame %d, instruction %d of the frame",
+                                    path, lane, frame, (step + 1) * cyclesPerStep - 1);
+                        if (!options.m_PerFrame) {
+                            std::printf(" (opcode %04X at %03X)", opcode, pc);
+                        }
+                        std::printf("\n");
+                        dumpDivergence(reference, candidate);
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::vector<const char*> roms;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options.m_Frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--lanes") == 0 && i + 1 < argc) {
+            options.m_Lanes = static_cast<std::size_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.m_Seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        } else if (std::strcmp(argv[i], "--per-frame") == 0) {
+            options.m_PerFrame = true;
+        } else if (std::strcmp(argv[i], "--predecode") == 0) {
+            options.m_Predecode = true;
+        } else {
+            roms.push_back(argv[i]);
+        }
+    }
+
+    if (roms.empty() || options.m_Lanes == 0) {
+        std::fprintf(stderr, "Usage: %s [--frames N] [--lanes L] [--seed S] [--per-frame] [--predecode] ROM...\n", argv[0]);
+        return 2;
+    }
+
+    for (const char* path : roms) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            std::fprintf(stderr, "Failed to open ROM: %s\n", path);
+            return 2;
+        }
+        const std::vector<uint8_t> rom((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        const auto start = std::chrono::steady_clock::now();
+        if (!runRom(path, rom, options)) {
+            return 1;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%s: OK, %d frames x %zu lanes in %.2fs\n", path, options.m_Frames, options.m_Lanes, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+//
+// State-space search over keypad inputs: finds the shortest sequence of per-frame key presses (BFS), or a
+// good one (beam search), that takes a ROM from power-on to a goal state.
+//
+// Usage: chip8-explore ROM --goal GOAL [--depth N] [--beam W] [--threads T] [--memory MB] [--cycles C] [--seed S]
+//
+// GOAL is one of:
+//   VX>=N   register X (hex digit) reaches at least N, e.g. VE>=3 for a score kept in VE
+//   VX==N   register X equals N exactly
+//   pc=ADDR the program counter reaches ADDR (hex)
+//   escape  the program counter leaves the loaded ROM, which is how most crashes start
+//
+// With a register goal the beam keeps the states with the highest value in that register.
+// Exits with 0 if the goal was reached, 1 if not, and 2 on a usage or I/O error.
+//
+
+#include "CHIP8BootImage.h"
+#include "CHIP8Explorer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    struct GoalSpec {
+        enum Kind { REGISTER_AT_LEAST, REGISTER_EQUALS, PROGRAM_COUNTER, ESCAPE } m_Kind;
+        int m_Register = 0;
+        unsigned long m_Value = 0;
+    };
+
+    bool parseGoal(const char* text, GoalSpec& goal) {
+        char* end = nullptr;
+        if (std::strcmp(text, "escape") == 0) {
+            goal.m_Kind = GoalSpec::ESCAPE;
+            return true;
+        }
+        if (std::strncmp(text, "pc=", 3) == 0) {
+            goal.m_Kind = GoalSpec::PROGRAM_COUNTER;
+            goal.m_Value = std::strtoul(text + 3, &end, 16);
+            return end != text + 3 && *end == '\0';
+        }
+        if ((text[0] == 'V' || text[0] == 'v') && text[1] != '\0') {
+            const char digit[2] = {text[1], '\0'};
+            goal.m_Register = static_cast<int>(std::strtol(digit, &end, 16));
+            if (*end != '\0') {
+                return false;
+            }
+            const char* value = text + 2;
+            if (std::strncmp(value, ">=", 2) == 0) {
+                goal.m_Kind = GoalSpec::REGISTER_AT_LEAST;
+            } else if (std::strncmp(value, "==", 2) == 0) {
+                goal.m_Kind = GoalSpec::REGISTER_EQUALS;
+            } else {
+                return false;
+            }
+            goal.m_Value = std::strtoul(value + 2, &end, 0);
+            return end != value + 2 && *end == '\0';
+        }
+        return false;
+    }
+
+    void usage(const char* program) {
+        std::fprintf(stderr, "Usage: %s ROM --goal VX>=N|VX==N|pc=ADDR|escape [--depth N] [--beam W] "
+                             "[--threads T] [--memory MB] [--cycles C] [--seed S]\n", program);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* romPath = nullptr;
+    const char* goalText = nullptr;
+    ExplorerConfig config;
+    uint32_t seed = 0x2545F491u;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--goal") == 0 && hasValue) {
+            goalText = argv[++i];
+        } else if (std::strcmp(argv[i], "--depth") == 0 && hasValue) {
+            config.m_MaxDepth = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--beam") == 0 && hasValue) {
+            config.m_BeamWidth = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            config.m_Threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--memory") == 0 && hasValue) {
+            config.m_MemoryLimit = std::strtoull(argv[++i], nullptr, 10) << 20;
+        } else if (std::strcmp(argv[i], "--cycles") == 0 && hasValue) {
+            config.m_CyclesPerFrame = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        } else if (!romPath && argv[i][0] != '-') {
+            romPath = argv[i];
+        } else {
+            romPath = nullptr;
+            break;
+        }
+    }
+
+    GoalSpec spec;
+    if (!romPath || !goalText || !parseGoal(goalText, spec)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    CHIP8BootImage image;
+    if (!image.loadFile(romPath)) {
+        return 2;
+    }
+    CHIP8Context start;
+    image.boot(start, seed);
+
+    const uint16_t romEnd = static_cast<uint16_t>(CHIP8BootImage::ROM_BASE + image.romSize());
+    const CHIP8Explorer::Goal goal = [spec, romEnd](const CHIP8Context& state) {
+        switch (spec.m_Kind) {
+            case GoalSpec::REGISTER_AT_LEAST:
+                return state.m_Registers[spec.m_Register] >= spec.m_Value;
+            case GoalSpec::REGISTER_EQUALS:
+                return state.m_Registers[spec.m_Register] == spec.m_Value;
+            case GoalSpec::PROGRAM_COUNTER:
+                return (state.m_ProgramCounter & 0x0FFF) == spec.m_Value;
+            case GoalSpec::ESCAPE:
+                break;
+        }
+        const uint16_t pc = state.m_ProgramCounter & 0x0FFF;
+        return pc < CHIP8BootImage::ROM_BASE || pc >= romEnd;
+    };
+    CHIP8Explorer::Score score;
+    if (spec.m_Kind == GoalSpec::REGISTER_AT_LEAST || spec.m_Kind == GoalSpec::REGISTER_EQUALS) {
+        const int reg = spec.m_Register;
+        score = [reg](const CHIP8Context& state) { return static_cast<int64_t>(state.m_Registers[reg]); };
+    }
+
+    const CHIP8Explorer::Progress progress = [](const ExplorerProgress& p) {
+        std::fprintf(stderr, "depth %4d  frontier %9zu  unique %10llu  %9.0f states/s  %7.1f MB\n",
+                     p.m_Depth, p.m_Frontier, static_cast<unsigned long long>(p.m_Unique),
+                     p.m_Seconds > 0 ? p.m_Expanded / p.m_Seconds : 0.0, p.m_Bytes / 1048576.0);
+    };
+
+    CHIP8Explorer explorer(config);
+    const ExplorerResult result = explorer.run(start, goal, score, progress);
+
+    std::printf("%s: %s at depth %d after %llu states (%llu unique) in %.2fs, %.0f states/s, peak %.1f MB%s\n",
+                romPath, result.m_Found ? "goal reached" : "goal not reached", result.m_Depth,
+                static_cast<unsigned long long>(result.m_Expanded), static_cast<unsigned long long>(result.m_Unique),
+                result.m_Seconds, result.m_Seconds > 0 ? result.m_Expanded / result.m_Seconds : 0.0,
+                result.m_PeakBytes / 1048576.0, result.m_HitMemoryLimit ? " (memory limit hit)" : "");
+    if (!result.m_Found) {
+        return 1;
+    }
+
+    // One character per frame: the held key in hex, or '-' for none.
+    std::printf("inputs: ");
+    for (uint16_t keys : result.m_Inputs) {
+        int key = 0;
+        while (keys && !(keys & (1u << key))) {
+            ++key;
+        }
+        std::putchar(keys ? "0123456789ABCDEF"[key] : '-');
+    }
+    std::printf("\nfinal PC=%03X I=%03X V:", result.m_State.m_ProgramCounter & 0x0FFF, result.m_State.m_AddressI);
+    for (int i = 0; i < 16; ++i) {
+        std::printf(" %02X", result.m_State.m_Registers[i]);
+    }
+    std::printf("\n");
+    return 0;
+}
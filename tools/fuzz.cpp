@@ -0,0 +1,128 @@
+//
+// Fuzzing target for the decoder and executor, usable from libFuzzer, AFL or as a plain replay tool.
+//
+// An input is a ROM followed by an input script:
+//
+//     u16 romSize   little-endian, clamped to what is left of the input
+//     u8  rom[romSize]
+//     u8  keys[]    one byte per frame: bit 4 set means key (low nibble) is held, otherwise no key
+//
+// Each frame runs CYCLES_PER_FRAME instructions, for at most MAX_FRAMES frames, so every input terminates.
+// The machine is reset in place between inputs: no allocation and no file I/O on the hot path.
+//
+// With -DCHIP8_BUILD_FUZZER=ON and clang, chip8-fuzz is a libFuzzer binary. Otherwise it is a
+// standalone program that runs each file given on the command line (or stdin, for AFL).
+//
+
+#include "CHIP8.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    const int CYCLES_PER_FRAME = 15;
+    const size_t MAX_FRAMES = 512;
+    const uint32_t FUZZ_SEED = 0x2545F491u;
+
+    CHIP8Context machine;
+
+    // Properties every instruction must preserve, whatever the ROM does.
+    void checkInvariants(const CHIP8Context& chip8) {
+        if (chip8.m_StackPointer > 16) {
+            std::fprintf(stderr, "stack pointer out of range: %u\n", chip8.m_StackPointer);
+            std::abort();
+        }
+        for (int x = 0; x < 64; ++x) {
+            for (int y = 0; y < 32; ++y) {
+                if (chip8.m_ScreenData[x][y] > 1) {
+                    std::fprintf(stderr, "pixel (%d, %d) is %u\n", x, y, chip8.m_ScreenData[x][y]);
+                    std::abort();
+                }
+            }
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 2) {
+        return 0;
+    }
+
+    size_t romSize = static_cast<size_t>(data[0] | (data[1] << 8));
+    if (romSize > size - 2) {
+        romSize = size - 2;
+    }
+    const uint8_t* rom = data + 2;
+    const uint8_t* script = rom + romSize;
+    size_t frames = size - 2 - romSize;
+    if (frames == 0) {
+        frames = 1; // a ROM with no script still runs one frame with no keys held
+    }
+    if (frames > MAX_FRAMES) {
+        frames = MAX_FRAMES;
+    }
+
+    machine.resetState();
+    machine.seedRandom(FUZZ_SEED);
+    machine.loadROM(rom, romSize);
+
+    for (size_t frame = 0; frame < frames; ++frame) {
+        const uint8_t keys = script + frame < data + size ? script[frame] : 0;
+        machine.m_Keypad = (keys & 0x10) ? static_cast<uint16_t>(1u << (keys & 0x0F)) : 0;
+        machine.runCycles(CYCLES_PER_FRAME);
+        checkInvariants(machine);
+    }
+    return 0;
+}
+
+#ifndef CHIP8_LIBFUZZER
+namespace {
+    bool runFile(FILE* in, const char* name) {
+        std::vector<uint8_t> input;
+        uint8_t buffer[4096];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), in)) > 0) {
+            input.insert(input.end(), buffer, buffer + read);
+        }
+        if (std::ferror(in)) {
+            std::fprintf(stderr, "Failed to read %s\n", name);
+            return false;
+        }
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+#ifdef __AFL_LOOP
+        // AFL persistent mode: many inputs per process.
+        while (__AFL_LOOP(10000)) {
+            if (!runFile(stdin, "stdin")) {
+                return 1;
+            }
+        }
+        return 0;
+#else
+        return runFile(stdin, "stdin") ? 0 : 1;
+#endif
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        FILE* in = std::fopen(argv[i], "rb");
+        if (!in) {
+            std::fprintf(stderr, "Failed to open %s\n", argv[i]);
+            return 1;
+        }
+        const bool ok = runFile(in, argv[i]);
+        std::fclose(in);
+        if (!ok) {
+            return 1;
+        }
+        std::printf("%s: OK\n", argv[i]);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,444 @@
+//
+// A GDB remote serial protocol stub for a CHIP-8 machine, so debuggers and scripts can attach over TCP.
+//
+// Usage: chip8-gdbserver ROM [--port PORT] [--seed S]
+//
+// Listens on 127.0.0.1:PORT (default 1234) for one client. Supported packets:
+//   ?                    last stop reason
+//   g / G                read / write all registers
+//   m ADDR,LEN           read memory
+//   M ADDR,LEN:BYTES     write memory
+//   c [ADDR] / s [ADDR]  continue / single-step, optionally from ADDR
+//   Z0/z0, Z1/z1         set / clear a breakpoint
+//   Z2/z2, Z3/z3, Z4/z4  set / clear a write, read or access watchpoint
+//   k / D                kill / detach; both end the session
+// A 0x03 byte from the client interrupts a continue; disconnecting during one ends the session.
+//
+// Registers, in the order g and G use: V0..VF (1 byte each), I (2 bytes), PC (2 bytes), SP, DT, ST
+// (1 byte each). Multi-byte values are little-endian, as GDB expects.
+//
+// Watchpoint stops are reported after the accessing instruction, as GDB expects of hardware watchpoints;
+// the debugger core itself stops just before it.
+//
+
+#include "CHIP8BootImage.h"
+#include "CHIP8Debugger.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    const int REGISTER_BYTES = 16 + 2 + 2 + 3;
+    const int INSTRUCTIONS_PER_POLL = 1000; // how often a continue checks for an interrupt
+
+    const char HEX[] = "0123456789abcdef";
+
+    void appendHex(std::string& out, uint8_t byte) {
+        out += HEX[byte >> 4];
+        out += HEX[byte & 0x0F];
+    }
+
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Parses hex bytes; returns false on odd length or a bad digit.
+    bool parseHexBytes(const char* text, size_t digits, uint8_t* out) {
+        if (digits % 2) {
+            return false;
+        }
+        for (size_t i = 0; i < digits; i += 2) {
+            const int high = hexValue(text[i]);
+            const int low = hexValue(text[i + 1]);
+            if (high < 0 || low < 0) {
+                return false;
+            }
+            out[i / 2] = static_cast<uint8_t>(high << 4 | low);
+        }
+        return true;
+    }
+
+    class GdbConnection {
+    public:
+        explicit GdbConnection(int socket) : m_Socket(socket) {}
+        ~GdbConnection() { ::close(m_Socket); }
+
+        // Reads the next packet body, acknowledging it and asking again for any with a bad checksum.
+        // An interrupt byte is returned as "\x03".
+        bool receive(std::string& packet) {
+            for (;;) {
+                packet.clear();
+                char c;
+                do {
+                    if (!readByte(c)) {
+                        return false;
+                    }
+                    if (c == 0x03) {
+                        packet = "\x03";
+                        return true;
+                    }
+                } while (c != '$');
+
+                while (readByte(c) && c != '#') {
+                    packet += c;
+                }
+                char checksum[2];
+                if (!readByte(checksum[0]) || !readByte(checksum[1])) {
+                    return false;
+                }
+                uint8_t sum = 0;
+                for (char byte : packet) {
+                    sum = static_cast<uint8_t>(sum + static_cast<uint8_t>(byte));
+                }
+                const bool valid = hexValue(checksum[0]) == (sum >> 4) && hexValue(checksum[1]) == (sum & 0x0F);
+                if (!writeAll(valid ? "+" : "-", 1)) {
+                    return false;
+                }
+                if (valid) {
+                    return true;
+                }
+            }
+        }
+
+        // Sends a packet and waits for the client's acknowledgement, resending on a NAK.
+        bool send(const std::string& body) {
+            uint8_t sum = 0;
+            for (char byte : body) {
+                sum = static_cast<uint8_t>(sum + static_cast<uint8_t>(byte));
+            }
+            std::string packet = "$" + body + "#";
+            appendHex(packet, sum);
+
+            for (;;) {
+                if (!writeAll(packet.data(), packet.size())) {
+                    return false;
+                }
+                char ack;
+                do {
+                    if (!readByte(ack)) {
+                        return false;
+                    }
+                } while (ack != '+' && ack != '-');
+                if (ack == '+') {
+                    return true;
+                }
+            }
+        }
+
+        // True if the client sent an interrupt or went away; other pending bytes are left alone.
+        bool interrupted() {
+            pollfd pending{m_Socket, POLLIN, 0};
+            if (::poll(&pending, 1, 0) <= 0) {
+                return false;
+            }
+            char c;
+            if ((pending.revents & (POLLERR | POLLHUP | POLLNVAL)) || ::recv(m_Socket, &c, 1, MSG_PEEK) <= 0) {
+                m_Closed = true;
+                return true;
+            }
+            if (c == 0x03) {
+                readByte(c);
+                return true;
+            }
+            return false;
+        }
+
+        bool closed() const { return m_Closed; }
+
+    private:
+        int m_Socket;
+        bool m_Closed = false; // the client disconnected or the socket failed
+
+        bool readByte(char& c) {
+            if (::recv(m_Socket, &c, 1, 0) == 1) {
+                return true;
+            }
+            m_Closed = true;
+            return false;
+        }
+
+        bool writeAll(const char* data, size_t size) {
+            while (size > 0) {
+                const ssize_t sent = ::send(m_Socket, data, size, 0);
+                if (sent <= 0) {
+                    m_Closed = true;
+                    return false;
+                }
+                data += sent;
+                size -= static_cast<size_t>(sent);
+            }
+            return true;
+        }
+    };
+
+    class GdbStub {
+    public:
+        GdbStub(CHIP8Context& chip8, GdbConnection& connection) : m_Chip8(chip8), m_Connection(connection) {}
+
+        // Serves packets until the client kills, detaches or disconnects.
+        void serve() {
+            std::string packet;
+            while (m_Connection.receive(packet)) {
+                if (packet == "\x03") {
+                    continue; // an interrupt with nothing running
+                }
+                std::string reply;
+                if (!handle(packet, reply)) {
+                    m_Connection.send("OK");
+                    return;
+                }
+                if (m_Connection.closed() || !m_Connection.send(reply)) {
+                    return;
+                }
+            }
+        }
+
+    private:
+        CHIP8Context& m_Chip8;
+        GdbConnection& m_Connection;
+        CHIP8Debugger m_Debugger;
+        std::string m_LastStop = "S05";
+
+        // Returns false when the session should end.
+        bool handle(const std::string& packet, std::string& reply) {
+            const char* args = packet.c_str() + 1;
+            switch (packet.empty() ? '\0' : packet[0]) {
+                case '?':
+                    reply = m_LastStop;
+                    break;
+                case 'g':
+                    readRegisters(reply);
+                    break;
+                case 'G':
+                    reply = writeRegisters(args, packet.size() - 1) ? "OK" : "E01";
+                    break;
+                case 'm':
+                    readMemory(args, reply);
+                    break;
+                case 'M':
+                    reply = writeMemory(args) ? "OK" : "E01";
+                    break;
+                case 'c':
+                case 's':
+                    if (*args) {
+                        m_Chip8.m_ProgramCounter = static_cast<uint16_t>(std::strtoul(args, nullptr, 16) & 0x0FFF);
+                    }
+                    reply = m_LastStop = packet[0] == 'c' ? resume() : stopReply(m_Debugger.step(m_Chip8));
+                    break;
+                case 'Z':
+                case 'z':
+                    reply = setPoint(packet[0] == 'Z', args) ? "OK" : "";
+                    break;
+                case 'H':
+                    reply = "OK"; // one thread only
+                    break;
+                case 'k':
+                case 'D':
+                    return false;
+                case 'q':
+                    if (packet.compare(0, 10, "qSupported") == 0) {
+                        reply = "PacketSize=4000";
+                    } else if (packet == "qAttached") {
+                        reply = "1";
+                    }
+                    break;
+                default:
+                    break; // an empty reply tells GDB the packet is not supported
+            }
+            return true;
+        }
+
+        void readRegisters(std::string& reply) {
+            for (uint8_t value : m_Chip8.m_Registers) {
+                appendHex(reply, value);
+            }
+            appendHex(reply, m_Chip8.m_AddressI & 0xFF);
+            appendHex(reply, m_Chip8.m_AddressI >> 8);
+            appendHex(reply, m_Chip8.m_ProgramCounter & 0xFF);
+            appendHex(reply, m_Chip8.m_ProgramCounter >> 8);
+            appendHex(reply, m_Chip8.m_StackPointer);
+            appendHex(reply, m_Chip8.m_DelayTimer);
+            appendHex(reply, m_Chip8.m_SoundTimer);
+        }
+
+        bool writeRegisters(const char* hex, size_t digits) {
+            uint8_t bytes[REGISTER_BYTES];
+            // SP counts used stack entries, so a full stack is valid; anything deeper is refused, not clamped.
+            const size_t stackDepth = sizeof(m_Chip8.m_Stack) / sizeof(m_Chip8.m_Stack[0]);
+            if (digits != 2 * REGISTER_BYTES || !parseHexBytes(hex, digits, bytes) || bytes[20] > stackDepth) {
+                return false;
+            }
+            std::memcpy(m_Chip8.m_Registers, bytes, 16);
+            m_Chip8.m_AddressI = static_cast<uint16_t>(bytes[16] | bytes[17] << 8);
+            m_Chip8.m_ProgramCounter = static_cast<uint16_t>((bytes[18] | bytes[19] << 8) & 0x0FFF);
+            m_Chip8.m_StackPointer = bytes[20];
+            m_Chip8.m_DelayTimer = bytes[21];
+            m_Chip8.m_SoundTimer = bytes[22];
+            return true;
+        }
+
+        void readMemory(const char* args, std::string& reply) {
+            char* end;
+            const unsigned long address = std::strtoul(args, &end, 16);
+            const unsigned long length = *end == ',' ? std::strtoul(end + 1, nullptr, 16) : 0;
+            if (length == 0 || length > 0x1000) {
+                reply = "E01";
+                return;
+            }
+            // Addresses wrap at 4K exactly as the interpreter's own accesses do.
+            for (unsigned long i = 0; i < length; ++i) {
+                appendHex(reply, m_Chip8.m_GameMemory[(address + i) & 0x0FFF]);
+            }
+        }
+
+        bool writeMemory(const char* args) {
+            char* end;
+            const unsigned long address = std::strtoul(args, &end, 16);
+            if (*end != ',') {
+                return false;
+            }
+            const unsigned long length = std::strtoul(end + 1, &end, 16);
+            if (*end != ':' || length > 0x1000 || std::strlen(end + 1) != 2 * length) {
+                return false;
+            }
+            uint8_t bytes[0x1000];
+            if (!parseHexBytes(end + 1, 2 * length, bytes)) {
+                return false;
+            }
+            CHIP8Debugger::writeMemory(m_Chip8, static_cast<uint16_t>(address), bytes, length);
+            return true;
+        }
+
+        bool setPoint(bool enabled, const char* args) {
+            char* end;
+            const unsigned long type = std::strtoul(args, &end, 10);
+            if (*end != ',') {
+                return false;
+            }
+            const unsigned long address = std::strtoul(end + 1, &end, 16);
+            const unsigned long length = *end == ',' ? std::strtoul(end + 1, nullptr, 16) : 1;
+            switch (type) {
+                case 0:
+                case 1:
+                    m_Debugger.setBreakpoint(static_cast<uint16_t>(address), enabled);
+                    return true;
+                case 2:
+                    m_Debugger.setWatchpoint(static_cast<uint16_t>(address), length, CHIP8Debugger::WATCH_WRITE, enabled);
+                    return true;
+                case 3:
+                    m_Debugger.setWatchpoint(static_cast<uint16_t>(address), length, CHIP8Debugger::WATCH_READ, enabled);
+                    return true;
+                case 4:
+                    m_Debugger.setWatchpoint(static_cast<uint16_t>(address), length,
+                                             CHIP8Debugger::WATCH_READ | CHIP8Debugger::WATCH_WRITE, enabled);
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        std::string resume() {
+            for (;;) {
+                const CHIP8StopInfo stop = m_Debugger.run(m_Chip8, INSTRUCTIONS_PER_POLL);
+                if (stop.m_Reason == CHIP8StopReason::NONE) {
+                    if (m_Connection.interrupted()) {
+                        return m_Connection.closed() ? "" : "S02";
+                    }
+                    continue;
+                }
+                if (stop.m_Reason == CHIP8StopReason::WATCH_READ || stop.m_Reason == CHIP8StopReason::WATCH_WRITE) {
+                    m_Debugger.step(m_Chip8); // report after the access, like a hardware watchpoint
+                }
+                return stopReply(stop);
+            }
+        }
+
+        std::string stopReply(const CHIP8StopInfo& stop) {
+            if (stop.m_Reason != CHIP8StopReason::WATCH_READ && stop.m_Reason != CHIP8StopReason::WATCH_WRITE) {
+                return "S05";
+            }
+            // A byte watched for both reads and writes was set with Z4, which GDB calls an access watchpoint.
+            const uint8_t both = CHIP8Debugger::WATCH_READ | CHIP8Debugger::WATCH_WRITE;
+            const char* kind = (m_Debugger.flags(stop.m_Address) & both) == both ? "awatch"
+                : stop.m_Reason == CHIP8StopReason::WATCH_READ ? "rwatch" : "watch";
+            char reply[32];
+            std::snprintf(reply, sizeof(reply), "T05%s:%x;", kind, stop.m_Address);
+            return reply;
+        }
+    };
+}
+
+int main(int argc, char* argv[]) {
+    const char* romPath = nullptr;
+    int port = 1234;
+    uint32_t seed = 0x2545F491u;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        } else if (!romPath && argv[i][0] != '-') {
+            romPath = argv[i];
+        } else {
+            romPath = nullptr;
+            break;
+        }
+    }
+    if (!romPath) {
+        std::fprintf(stderr, "Usage: %s ROM [--port PORT] [--seed S]\n", argv[0]);
+        return 2;
+    }
+
+    CHIP8BootImage image;
+    if (!image.loadFile(romPath)) {
+        return 1;
+    }
+    CHIP8Context chip8;
+    image.boot(chip8, seed);
+
+    // A client that disconnects mid-reply must end the session, not the process.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int reuse = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // local tooling only: the protocol has no authentication
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, 1) != 0) {
+        std::perror("chip8-gdbserver");
+        return 1;
+    }
+    std::printf("%s: waiting for a debugger on 127.0.0.1:%d\n", romPath, port);
+    std::fflush(stdout);
+
+    const int client = ::accept(listener, nullptr, nullptr);
+    ::close(listener);
+    if (client < 0) {
+        std::perror("accept");
+        return 1;
+    }
+    const int noDelay = 1;
+    ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    GdbConnection connection(client);
+    GdbStub stub(chip8, connection);
+    stub.serve();
+    return 0;
+}
@@ -0,0 +1,162 @@
+//
+// Runs two rollback netplay peers in one process over loopback UDP, with simulated latency, jitter and
+// packet loss, and checks that both end up with exactly the history a local run of the same inputs gives.
+//
+// Usage: chip8-netplay-loopback [--rom Pong.ch8] [--frames 600] [--latency MS] [--jitter MS] [--loss 0..1]
+//                               [--frame-ms MS] [--port BASE]
+//
+
+#include "CHIP8.h"
+#include "Netplay.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace {
+    const uint32_t SHARED_SEED = 0xC8C8C8C8u;
+
+    struct ScriptedPlayer {
+        uint16_t m_Keys[2];  // the two keys this player uses
+        uint16_t m_Held = 0;
+        uint32_t m_Random;
+        int m_FramesLeft = 0;
+
+        // Holds a random one of its keys (or nothing) for a random number of frames.
+        uint16_t next() {
+            if (m_FramesLeft-- <= 0) {
+                m_Random = m_Random * 1664525u + 1013904223u;
+                const uint32_t choice = (m_Random >> 16) % 3;
+                m_Held = choice == 2 ? 0 : static_cast<uint16_t>(1u << m_Keys[choice]);
+                m_FramesLeft = 1 + static_cast<int>((m_Random >> 24) % 20);
+            }
+            return m_Held;
+        }
+    };
+
+    void boot(CHIP8Context& chip8, const std::vector<uint8_t>& rom) {
+        chip8.resetState();
+        chip8.seedRandom(SHARED_SEED);
+        chip8.loadROM(rom.data(), rom.size());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* romPath = "Pong.ch8";
+    int frames = 600;
+    double frameMs = 1000.0 / 60.0;
+    int basePort = 47310;
+    NetplayConfig config;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--rom") == 0) romPath = argv[i + 1];
+        else if (std::strcmp(argv[i], "--frames") == 0) frames = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--latency") == 0) config.m_SimulatedLatencyMs = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--jitter") == 0) config.m_SimulatedJitterMs = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--loss") == 0) config.m_SimulatedLossRate = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--frame-ms") == 0) frameMs = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--port") == 0) basePort = std::atoi(argv[i + 1]);
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::ifstream in(romPath, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "Failed to open ROM: %s\n", romPath);
+        return 1;
+    }
+    const std::vector<uint8_t> rom((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    NetplayConfig configs[2] = { config, config };
+    for (int player = 0; player < 2; ++player) {
+        configs[player].m_LocalPlayer = player;
+        configs[player].m_LocalPort = static_cast<uint16_t>(basePort + player);
+        configs[player].m_RemotePort = static_cast<uint16_t>(basePort + 1 - player);
+    }
+
+    NetplaySession sessions[2];
+    CHIP8Context machines[2];
+    std::vector<uint64_t> hashLogs[2];
+    std::vector<uint16_t> inputs[2];
+    // Pong: player one uses keys 1 and 4, player two uses C and D.
+    ScriptedPlayer players[2] = { { { 0x1, 0x4 }, 0, 12345u }, { { 0xC, 0xD }, 0, 67890u } };
+
+    for (int player = 0; player < 2; ++player) {
+        if (!sessions[player].open(configs[player])) {
+            return 1;
+        }
+        sessions[player].m_ConfirmedHashLog = &hashLogs[player];
+        boot(machines[player], rom);
+    }
+
+    // Both peers tick at the same nominal rate, as two cabinets would.
+    const auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; sessions[0].m_Frame < static_cast<uint32_t>(frames) || sessions[1].m_Frame < static_cast<uint32_t>(frames); ++tick) {
+        for (int player = 0; player < 2; ++player) {
+            if (sessions[player].m_Frame >= static_cast<uint32_t>(frames)) {
+                sessions[player].poll(machines[player]);
+                continue;
+            }
+            const uint16_t keys = inputs[player].size() > sessions[player].m_Frame
+                ? inputs[player][sessions[player].m_Frame]
+                : players[player].next();
+            if (inputs[player].size() == sessions[player].m_Frame) {
+                inputs[player].push_back(keys);
+            }
+            sessions[player].advanceFrame(machines[player], keys);
+        }
+        std::this_thread::sleep_until(start + std::chrono::duration<double, std::milli>(frameMs * (tick + 1)));
+    }
+
+    // Let the last inputs arrive so every frame becomes confirmed on both sides.
+    const auto drainUntil = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((hashLogs[0].size() < static_cast<size_t>(frames) || hashLogs[1].size() < static_cast<size_t>(frames))
+           && std::chrono::steady_clock::now() < drainUntil) {
+        sessions[0].poll(machines[0]);
+        sessions[1].poll(machines[1]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // The ground truth: one machine fed both players' real inputs, with no network in between.
+    CHIP8Context reference;
+    boot(reference, rom);
+    int firstMismatch = -1;
+    for (int frame = 0; frame < frames; ++frame) {
+        reference.m_Keypad = inputs[0][frame] | inputs[1][frame];
+        reference.runCycles(configs[0].m_CyclesPerFrame);
+        const uint64_t hash = reference.stateHash();
+
+        for (int player = 0; player < 2; ++player) {
+            if (firstMismatch < 0 && (frame >= static_cast<int>(hashLogs[player].size()) || hashLogs[player][frame] != hash)) {
+                firstMismatch = frame;
+            }
+        }
+    }
+
+    for (int player = 0; player < 2; ++player) {
+        const NetplaySession& s = sessions[player];
+        std::printf("player %d: frames %u, confirmed %zu, rollbacks %llu, resimulated %llu, max depth %d, "
+                    "stalls %llu, sent %llu, dropped %llu%s\n",
+                    player, s.m_Frame, hashLogs[player].size(),
+                    static_cast<unsigned long long>(s.m_Rollbacks),
+                    static_cast<unsigned long long>(s.m_ResimulatedFrames), s.m_MaxRollbackFrames,
+                    static_cast<unsigned long long>(s.m_StalledFrames),
+                    static_cast<unsigned long long>(s.m_PacketsSent),
+                    static_cast<unsigned long long>(s.m_PacketsDropped),
+                    s.m_Desynced ? ", DESYNCED" : "");
+    }
+
+    if (firstMismatch >= 0) {
+        std::printf("FAIL: peers diverge from the reference at frame %d\n", firstMismatch);
+        return 1;
+    }
+    std::printf("OK: both peers match the reference for all %d frames\n", frames);
+    return 0;
+}
@@ -0,0 +1,105 @@
+//
+// Runs a ROM in the terminal: the screen drawn with ANSI escapes and half blocks, keys read from stdin.
+// Meant for hosts without a display, including over SSH and serial consoles.
+//
+// Usage: chip8-term [ROM] [--hold FRAMES] [--cycles N]
+//
+// Keys use the SDL frontend's layout (1234/QWER/ASDF/ZXCV). Escape or Ctrl-C quits.
+//
+
+#include "CHIP8BootImage.h"
+#include "TerminalDisplay.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    const char* romPath = "Pong.ch8";
+    int holdFrames = 10;
+    int cyclesPerFrame = 15;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--hold") == 0 && i + 1 < argc) {
+            holdFrames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cyclesPerFrame = std::atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            romPath = argv[i];
+        } else {
+            std::fprintf(stderr, "Usage: %s [ROM] [--hold FRAMES] [--cycles N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    CHIP8BootImage image;
+    if (!image.loadFile(romPath)) {
+        return 1;
+    }
+    CHIP8Context chip8;
+    image.boot(chip8, std::random_device{}());
+
+    TerminalDisplay display;
+    display.m_HoldFrames = holdFrames;
+    if (!display.open()) {
+        std::fprintf(stderr, "chip8-term needs a terminal on stdin\n");
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto framePeriod = std::chrono::microseconds(1000000 / 60);
+    auto nextFrame = Clock::now();
+    auto reportStart = Clock::now();
+    size_t bytesSinceReport = 0;
+    int framesSinceReport = 0;
+
+    std::vector<CHIP8KeyEvent> events;
+    uint16_t held = 0;
+    bool quit = false;
+
+    while (!quit) {
+        // Keys go in as events at the start of the frame, so FX0A sees the press and the release.
+        const uint16_t keys = display.pollKeys(quit);
+        events.clear();
+        for (uint8_t key = 0; key < 16; ++key) {
+            const uint16_t bit = static_cast<uint16_t>(1u << key);
+            if ((keys ^ held) & bit) {
+                CHIP8KeyEvent event;
+                event.cycle = 0;
+                event.key = key;
+                event.pressed = (keys & bit) != 0;
+                events.push_back(event);
+            }
+        }
+        held = keys;
+
+        chip8.runCycles(cyclesPerFrame, events.data(), events.size());
+        bytesSinceReport += display.render(chip8);
+        ++framesSinceReport;
+
+        const double seconds = std::chrono::duration<double>(Clock::now() - reportStart).count();
+        if (seconds >= 1.0) {
+            char text[96];
+            std::snprintf(text, sizeof(text), "%s  %.0f fps  %.0f bytes/frame  (Esc quits)", romPath,
+                          framesSinceReport / seconds, static_cast<double>(bytesSinceReport) / framesSinceReport);
+            display.status(text);
+            reportStart = Clock::now();
+            bytesSinceReport = 0;
+            framesSinceReport = 0;
+        }
+
+        nextFrame += framePeriod;
+        const auto now = Clock::now();
+        if (nextFrame < now) {
+            nextFrame = now; // fell behind, e.g. a stalled terminal: don't try to catch up
+        }
+        std::this_thread::sleep_until(nextFrame);
+    }
+
+    display.close();
+    return 0;
+}
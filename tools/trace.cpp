@@ -0,0 +1,98 @@
+//
+// Decodes binary execution traces written by TraceRecorder.
+//
+// Usage: chip8-trace print TRACE [--limit N]
+//        chip8-trace diff TRACE_A TRACE_B
+//
+
+#include "CHIP8Trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    const int DIFF_CONTEXT = 8; // records shown before the first divergence
+
+    int usage(const char* program) {
+        std::fprintf(stderr, "Usage: %s print TRACE [--limit N]\n"
+                             "       %s diff TRACE_A TRACE_B\n", program, program);
+        return 2;
+    }
+
+    int print(const char* path, uint64_t limit) {
+        TraceReader reader;
+        if (!reader.open(path)) {
+            std::fprintf(stderr, "Not a trace file: %s\n", path);
+            return 1;
+        }
+
+        TraceRecord record;
+        char line[160];
+        while (reader.m_Index < limit && reader.next(record)) {
+            formatTraceRecord(record, line, sizeof(line));
+            std::printf("%10llu %s\n", static_cast<unsigned long long>(reader.m_Index - 1), line);
+        }
+        return 0;
+    }
+
+    int diff(const char* pathA, const char* pathB) {
+        TraceReader a, b;
+        if (!a.open(pathA) || !b.open(pathB)) {
+            std::fprintf(stderr, "Could not open both traces\n");
+            return 2;
+        }
+
+        TraceRecord history[DIFF_CONTEXT];
+        TraceRecord recordA, recordB;
+        char line[160];
+
+        while (true) {
+            const bool moreA = a.next(recordA);
+            const bool moreB = b.next(recordB);
+
+            if (!moreA && !moreB) {
+                std::printf("Traces are identical (%llu records)\n", static_cast<unsigned long long>(a.m_Index));
+                return 0;
+            }
+
+            if (moreA && moreB && recordA == recordB) {
+                history[(a.m_Index - 1) % DIFF_CONTEXT] = recordA;
+                continue;
+            }
+
+            const uint64_t index = moreA ? a.m_Index - 1 : b.m_Index - 1;
+            std::printf("First divergence at record %llu\n", static_cast<unsigned long long>(index));
+
+            const uint64_t first = index > DIFF_CONTEXT ? index - DIFF_CONTEXT : 0;
+            for (uint64_t i = first; i < index; ++i) {
+                formatTraceRecord(history[i % DIFF_CONTEXT], line, sizeof(line));
+                std::printf("  %10llu %s\n", static_cast<unsigned long long>(i), line);
+            }
+
+            if (moreA) {
+                formatTraceRecord(recordA, line, sizeof(line));
+            }
+            std::printf("A %10llu %s\n", static_cast<unsigned long long>(index), moreA ? line : "<end of trace>");
+            if (moreB) {
+                formatTraceRecord(recordB, line, sizeof(line));
+            }
+            std::printf("B %10llu %s\n", static_cast<unsigned long long>(index), moreB ? line : "<end of trace>");
+            return 1;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && std::strcmp(argv[1], "print") == 0) {
+        uint64_t limit = UINT64_MAX;
+        if (argc >= 5 && std::strcmp(argv[3], "--limit") == 0) {
+            limit = std::strtoull(argv[4], nullptr, 10);
+        }
+        return print(argv[2], limit);
+    }
+    if (argc == 4 && std::strcmp(argv[1], "diff") == 0) {
+        return diff(argv[2], argv[3]);
+    }
+    return usage(argv[0]);
+}